@@ -0,0 +1,99 @@
+#include "Angle.h"
+
+// atan(2^-i) as a binary angle
+const PROGMEM uint16_t atan_table[] = { 8192, 4836, 2555, 1297, 651, 326,
+	163, 81, 41, 20, 10, 5, 3, 1 };
+static_assert( ANGLE_ITERATIONS <= sizeof(atan_table) / sizeof(atan_table[0]),
+	"ANGLE_ITERATIONS is more than atan_table holds" );
+
+// 1 / CORDIC gain, times ANGLE_ONE
+const int16_t CORDIC_K = 9949;
+
+//-----------------------------------------------------------------------------
+// 
+// angleAtan2
+//
+// CORDIC vectoring: rotates (x, y) onto the x axis, adding up the rotations
+// Inputs are scaled up first so small vectors (like a touch a few pixels
+// from the center of a knob) still get full precision
+//
+//-----------------------------------------------------------------------------
+uint16_t angleAtan2( int16_t y, int16_t x )
+{
+	uint16_t angle = 0;
+	if( (x == 0) && (y == 0) )
+	{
+		return 0;
+	}
+	// start in the right half plane
+	if( x < 0 )
+	{
+		x = -x;
+		y = -y;
+		angle = ANGLE_HALF;
+	}
+	// normalize so the largest component is in [4096, 8192), then the
+	// vector can't outgrow 16 bits once the gain is applied
+	int16_t ay = y < 0 ? -y : y;
+	int16_t m = x > ay ? x : ay;
+	while( m < 4096 )
+	{
+		// doubling rather than << since x and y can be negative
+		m *= 2;
+		x *= 2;
+		y *= 2;
+	}
+	while( m >= 8192 )
+	{
+		m >>= 1;
+		x >>= 1;
+		y >>= 1;
+	}
+	for( uint8_t i = 0; i < ANGLE_ITERATIONS; i++ )
+	{
+		// rotate towards the x axis: s is 0 to go clockwise (y > 0),
+		// -1 to go counterclockwise, (v ^ s) - s negates v when s is -1
+		int16_t s = -(int16_t)(y <= 0);
+		int16_t dx = ((x >> i) ^ s) - s;
+		int16_t dy = ((y >> i) ^ s) - s;
+		int16_t da = (pgm_read_word_near(atan_table + i) ^ s) - s;
+		x += dy;
+		y -= dx;
+		angle += da;
+	}
+	return angle;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// angleSinCos
+//
+// CORDIC rotation: rotates (K, 0) by angle, which ends at (cos, sin)
+//
+//-----------------------------------------------------------------------------
+void angleSinCos( uint16_t angle, int16_t *psin, int16_t *pcos )
+{
+	int16_t x = CORDIC_K;
+	int16_t y = 0;
+	bool flip = false;
+	// CORDIC only converges within a quarter turn of +x
+	if( (uint16_t)(angle + ANGLE_QUARTER) >= ANGLE_HALF )
+	{
+		angle += ANGLE_HALF;
+		flip = true;
+	}
+	int16_t z = (int16_t)angle;
+	for( uint8_t i = 0; i < ANGLE_ITERATIONS; i++ )
+	{
+		// same trick as angleAtan2, s is -1 when z is negative
+		int16_t s = z >> 15;
+		int16_t dx = ((x >> i) ^ s) - s;
+		int16_t dy = ((y >> i) ^ s) - s;
+		int16_t da = (pgm_read_word_near(atan_table + i) ^ s) - s;
+		x -= dy;
+		y += dx;
+		z -= da;
+	}
+	*psin = flip ? -y : y;
+	*pcos = flip ? -x : x;
+}
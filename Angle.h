@@ -0,0 +1,35 @@
+#ifndef _angle_h_
+#define _angle_h_
+
+#include "PanelPort.h"
+
+//*****************************************************************************
+//
+// Fixed point angles
+//
+// Angles are binary: a full turn is 65536, so they wrap for free and the
+// top 8 bits are the 0-255 angle the knob works in. Everything is integer
+// CORDIC, only shifts and adds, no divisions or float.
+// Positive angles turn from +x towards +y, which on screen is clockwise.
+//
+//*****************************************************************************
+
+// CORDIC steps, each one adds about a bit of precision (max 14)
+#ifndef ANGLE_ITERATIONS
+#define ANGLE_ITERATIONS 12
+#endif
+
+// sin and cos are scaled to this
+#define ANGLE_SHIFT 14
+#define ANGLE_ONE (1 << ANGLE_SHIFT)
+
+#define ANGLE_QUARTER 0x4000
+#define ANGLE_HALF 0x8000
+
+// angle of the point (x, y) around the origin
+uint16_t angleAtan2( int16_t y, int16_t x );
+
+// sine and cosine of angle, times ANGLE_ONE
+void angleSinCos( uint16_t angle, int16_t *psin, int16_t *pcos );
+
+#endif // _angle_h_
@@ -0,0 +1,113 @@
+#include "CallbackQueue.h"
+#include "Panel.h"
+
+//*****************************************************************************
+//
+// CallbackQueue class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+// 
+// Constructor
+//
+//-----------------------------------------------------------------------------
+CallbackQueue::CallbackQueue( void )
+{
+	_count = 0;
+	_coalesced = 0;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// post
+//
+// Queues the panel's method. A move of a value panel updates the panel's
+// last entry instead when that is a move as well, nothing else merges.
+// returns false when the queue is full and the caller has to call it
+//
+//-----------------------------------------------------------------------------
+bool CallbackQueue::post( Panel *ppanel, uint16_t x, uint16_t y,
+			uint8_t event, bool value )
+{
+	uint8_t i = _count;
+	if( value && (event == TOUCH_MOVE) )
+	{
+		// the panel's newest entry, moves can't jump over a release
+		while( (i > 0) && (_buf[i - 1].ppanel != ppanel) )
+		{
+			i--;
+		}
+		if( (i > 0) && (_buf[i - 1].event == TOUCH_MOVE) )
+		{
+			i--;
+			_coalesced++;
+		}
+		else
+		{
+			i = _count;
+		}
+	}
+	if( i == _count )
+	{
+		if( _count == CALLBACK_QUEUE_LEN )
+		{
+			return false;
+		}
+		_buf[i].ppanel = ppanel;
+		_count++;
+	}
+	_buf[i].x = x;
+	_buf[i].y = y;
+	_buf[i].event = event;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// drain
+//
+// Calls up to max waiting methods, oldest first, returns how many ran
+// Panel::getEvent() gives the event of the entry during the call. An entry
+// leaves the queue before its method runs, so the method can post again.
+//
+//-----------------------------------------------------------------------------
+uint8_t CallbackQueue::drain( uint8_t max )
+{
+	uint8_t ran = 0;
+	while( (_count > 0) && (ran < max) )
+	{
+		Callback c = _buf[0];
+		_count--;
+		for( uint8_t i = 0; i < _count; i++ )
+		{
+			_buf[i] = _buf[i + 1];
+		}
+		uint8_t event = Panel::_event;
+		Panel::_event = c.event;
+		c.ppanel->runMethod(c.x, c.y);
+		Panel::_event = event;
+		ran++;
+	}
+	return ran;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// remove
+//
+// Drops the panel's entries, for panels that are about to go away
+//
+//-----------------------------------------------------------------------------
+void CallbackQueue::remove( Panel *ppanel )
+{
+	uint8_t kept = 0;
+	for( uint8_t i = 0; i < _count; i++ )
+	{
+		if( _buf[i].ppanel != ppanel )
+		{
+			_buf[kept++] = _buf[i];
+		}
+	}
+	_count = kept;
+}
@@ -0,0 +1,59 @@
+#ifndef _callback_queue_h_
+#define _callback_queue_h_
+
+#include "PanelPort.h"
+
+class Panel;
+
+// calls that can be waiting at once
+#ifndef CALLBACK_QUEUE_LEN
+#define CALLBACK_QUEUE_LEN 8
+#endif
+
+//*****************************************************************************
+//
+// CallbackQueue class
+//
+// Bound methods waiting to be called, so a slow one doesn't hold up the
+// redraw of the touch that caused it. Panels post here instead of calling
+// their method once a queue is set with Panel::setQueue(), and the sketch
+// calls drain() whenever it has time, e.g. once per loop().
+//
+// Only moves of panels that hold a value, faders and knobs, are merged:
+// a move posted while the panel's last entry is a move too only updates
+// its point, so a fader dragged across the screen between two drains
+// calls its method once, with where it ended up. Presses, toggles and
+// releases each get their own entry, none of them is lost. When the
+// queue is full the method is called right away as before.
+//
+//*****************************************************************************
+struct Callback
+{
+	Panel *ppanel;
+	uint16_t x;
+	uint16_t y;
+	uint8_t event; // TouchEvent at the time of the last post
+};
+
+class CallbackQueue
+{
+	private:
+		Callback _buf[CALLBACK_QUEUE_LEN];
+		uint8_t _count;
+		// posts folded into an entry already waiting
+		uint16_t _coalesced;
+
+	public:
+		CallbackQueue( void );
+		bool post( Panel *ppanel, uint16_t x, uint16_t y, uint8_t event,
+			bool value = false );
+		uint8_t drain( uint8_t max = CALLBACK_QUEUE_LEN );
+		void remove( Panel *ppanel );
+		// inline functions
+		inline uint8_t available( void ){ return _count; }
+		inline void clear( void ){ _count = 0; }
+		inline uint16_t getCoalesced( void ){ return _coalesced; }
+		inline void resetCoalesced( void ){ _coalesced = 0; }
+};
+
+#endif // _callback_queue_h_
@@ -0,0 +1,105 @@
+#include "Damage.h"
+
+//*****************************************************************************
+//
+// Damage class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Damage::Damage( void )
+{
+	_count = 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// add
+//
+// Adds a region, merging it with any region it is cheaper to draw along with
+// If the list is full the region is merged with whichever region grows least
+//
+//-----------------------------------------------------------------------------
+void Damage::add( int16_t x, int16_t y, int16_t w, int16_t h )
+{
+	if( (w <= 0) || (h <= 0) )
+	{
+		return;
+	}
+	Rect r = { x, y, w, h };
+	while( true )
+	{
+		uint8_t i = 0;
+		while( i < _count )
+		{
+			Rect u = _rects[i];
+			// only touching or overlapping regions are candidates
+			if( (r.x <= u.x + u.w) && (u.x <= r.x + r.w) &&
+				(r.y <= u.y + u.h) && (u.y <= r.y + r.h) )
+			{
+				unite(u, r);
+				if( area(u) <= area(r) + area(_rects[i]) + DAMAGE_SLACK )
+				{
+					// merged region may now reach ones already checked
+					r = u;
+					_rects[i] = _rects[--_count];
+					i = 0;
+					continue;
+				}
+			}
+			i++;
+		}
+		if( _count < DAMAGE_MAX_RECTS )
+		{
+			break;
+		}
+		// full, fold into the region that grows least
+		uint8_t best = 0;
+		int32_t best_cost = 0x7FFFFFFF;
+		for( i = 0; i < _count; i++ )
+		{
+			Rect u = _rects[i];
+			unite(u, r);
+			int32_t cost = area(u) - area(_rects[i]);
+			if( cost < best_cost )
+			{
+				best_cost = cost;
+				best = i;
+			}
+		}
+		unite(r, _rects[best]);
+		_rects[best] = _rects[--_count];
+	}
+	_rects[_count++] = r;
+}
+
+//-----------------------------------------------------------------------------
+//
+// unite
+//
+// Grows a to cover b
+//
+//-----------------------------------------------------------------------------
+void Damage::unite( Rect &a, const Rect &b )
+{
+	int16_t x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+	int16_t y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+	a.x = a.x < b.x ? a.x : b.x;
+	a.y = a.y < b.y ? a.y : b.y;
+	a.w = x1 - a.x;
+	a.h = y1 - a.y;
+}
+
+//-----------------------------------------------------------------------------
+//
+// area
+//
+//-----------------------------------------------------------------------------
+int32_t Damage::area( const Rect &r )
+{
+	return (int32_t)r.w * r.h;
+}
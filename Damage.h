@@ -0,0 +1,45 @@
+#ifndef _damage_h_
+#define _damage_h_
+
+#include "Display.h"
+
+// most damaged regions kept before they start getting merged together
+#ifndef DAMAGE_MAX_RECTS
+#define DAMAGE_MAX_RECTS 8
+#endif
+
+// pixels of overdraw allowed when merging two regions
+// each extra region costs an address window, worth a few pixels
+#ifndef DAMAGE_SLACK
+#define DAMAGE_SLACK 32
+#endif
+
+//*****************************************************************************
+//
+// Damage class
+//
+// List of screen regions that need to be repainted
+// Overlapping or touching regions are merged as they are added when that
+// doesn't cost more pixels than drawing them separately
+//
+//*****************************************************************************
+class Damage
+{
+	private:
+		Rect _rects[DAMAGE_MAX_RECTS];
+		uint8_t _count;
+		static void unite( Rect &a, const Rect &b );
+		static int32_t area( const Rect &r );
+
+	public:
+		Damage( void );
+		void add( int16_t x, int16_t y, int16_t w, int16_t h );
+		// inline functions
+		inline uint8_t getCount( void ){ return _count; }
+		inline const Rect& getRect( uint8_t i ){ return _rects[i]; }
+		inline void clear( void ){ _count = 0; }
+		// order of the rest isn't kept
+		inline void remove( uint8_t i ){ _rects[i] = _rects[--_count]; }
+};
+
+#endif // _damage_h_
@@ -0,0 +1,831 @@
+#include "Display.h"
+
+//*****************************************************************************
+//
+// Display class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Display::Display( int16_t w, int16_t h, DrawCommand *batch,
+			uint8_t batch_max ) :
+			_width(w), _height(h), _batch(batch), _batch_max(batch_max)
+{
+	_scroll_top = h;
+	_scroll_h = 0;
+	_scroll = 0;
+	clearClip();
+#if DISPLAY_STATS
+	resetStats();
+	_batch_stats = _stats;
+#endif
+	_batch_len = 0;
+	_batch_depth = 0;
+	_yield = NULL;
+	_blit_started = false;
+	_blit_w = 0;
+	_win_x0 = _win_x1 = _win_y0 = _win_y1 = -1;
+}
+
+//-----------------------------------------------------------------------------
+//
+// begin
+//
+// Starts a transaction for a single primitive, unless batching
+//
+//-----------------------------------------------------------------------------
+void Display::begin( void )
+{
+	if( _batch_depth == 0 )
+	{
+		startWrite();
+		DISPLAY_COUNT(transactions, 1);
+		// someone else may have used the display since
+		_win_x0 = _win_x1 = _win_y0 = _win_y1 = -1;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// end
+//
+//-----------------------------------------------------------------------------
+void Display::end( void )
+{
+	if( _batch_depth == 0 )
+	{
+		endWrite();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeRect
+//
+// Clips a rectangle to the clip rect and sends or queues it
+// Must be called between begin() and end()
+//
+//-----------------------------------------------------------------------------
+void Display::writeRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color )
+{
+	// clip using 32 bit math so x + w can't overflow
+	int32_t x0 = x;
+	int32_t y0 = y;
+	int32_t x1 = (int32_t)x + w;
+	int32_t y1 = (int32_t)y + h;
+	if( x0 < _clip.x ) x0 = _clip.x;
+	if( y0 < _clip.y ) y0 = _clip.y;
+	if( x1 > _clip.x + _clip.w ) x1 = _clip.x + _clip.w;
+	if( y1 > _clip.y + _clip.h ) y1 = _clip.y + _clip.h;
+	if( (x0 >= x1) || (y0 >= y1) )
+	{
+		return;
+	}
+	if( (_scroll_h == 0) || (y1 <= _scroll_top) )
+	{
+		writeClipped(x0, y0, x1 - x0, y1 - y0, color);
+		return;
+	}
+	// fixed rows above the scroll area
+	if( y0 < _scroll_top )
+	{
+		writeClipped(x0, y0, x1 - x0, _scroll_top - y0, color);
+		y0 = _scroll_top;
+	}
+	// the content rows showing, which can wrap round the area's memory
+	int32_t show = (int32_t)_scroll_top + _scroll;
+	if( y0 < show ) y0 = show;
+	if( y1 > show + _scroll_h ) y1 = show + _scroll_h;
+	if( y0 >= y1 )
+	{
+		return;
+	}
+	int32_t m0 = _scroll_top + (y0 - _scroll_top) % _scroll_h;
+	int32_t wrap = m0 + (y1 - y0) - _height;
+	if( wrap > 0 )
+	{
+		writeClipped(x0, m0, x1 - x0, y1 - y0 - wrap, color);
+		writeClipped(x0, _scroll_top, x1 - x0, wrap, color);
+	}
+	else
+	{
+		writeClipped(x0, m0, x1 - x0, y1 - y0, color);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeClipped
+//
+// Sends or queues a rectangle already clipped, in memory rows
+//
+//-----------------------------------------------------------------------------
+void Display::writeClipped( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color )
+{
+	Rect r = { x, y, w, h };
+	DISPLAY_COUNT(drawn, (uint32_t)r.w * (uint32_t)r.h);
+	if( _batch_depth == 0 )
+	{
+		send(r, color);
+	}
+	else if( _batch_max > 0 )
+	{
+		queue(r, color);
+	}
+	else
+	{
+		// nothing to queue it in, a transaction of its own
+		startWrite();
+		DISPLAY_COUNT(transactions, 1);
+		_win_x0 = _win_x1 = _win_y0 = _win_y1 = -1;
+		send(r, color);
+		endWrite();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// queue
+//
+// Adds a clipped rectangle to the batch
+// It's folded into an earlier command in the same color that it continues
+// or is covered by, as long as nothing queued after that command overlaps
+// it, since then it would be drawn in the wrong order
+//
+//-----------------------------------------------------------------------------
+void Display::queue( const Rect &r, uint16_t color )
+{
+	for( int8_t i = _batch_len - 1; i >= 0; i-- )
+	{
+		Rect &q = _batch[i].r;
+		if( _batch[i].color == color )
+		{
+			// same rows, side by side
+			if( (q.y == r.y) && (q.h == r.h) &&
+				((q.x + q.w == r.x) || (r.x + r.w == q.x)) )
+			{
+				q.x = q.x < r.x ? q.x : r.x;
+				q.w += r.w;
+				return;
+			}
+			// same columns, one above the other
+			if( (q.x == r.x) && (q.w == r.w) &&
+				((q.y + q.h == r.y) || (r.y + r.h == q.y)) )
+			{
+				q.y = q.y < r.y ? q.y : r.y;
+				q.h += r.h;
+				return;
+			}
+			// already drawn
+			if( (r.x >= q.x) && (r.x + r.w <= q.x + q.w) &&
+				(r.y >= q.y) && (r.y + r.h <= q.y + q.h) )
+			{
+				return;
+			}
+		}
+		if( (r.x < q.x + q.w) && (q.x < r.x + r.w) &&
+			(r.y < q.y + q.h) && (q.y < r.y + r.h) )
+		{
+			break;
+		}
+	}
+	if( _batch_len == _batch_max )
+	{
+		sendBatch();
+	}
+	_batch[_batch_len].r = r;
+	_batch[_batch_len].color = color;
+	_batch_len++;
+}
+
+//-----------------------------------------------------------------------------
+//
+// send
+//
+// Writes a clipped rectangle, the column and row ranges are only sent when
+// they differ from the last ones
+// Must be called between startWrite() and endWrite()
+//
+//-----------------------------------------------------------------------------
+void Display::send( const Rect &r, uint16_t color )
+{
+	int16_t x1 = r.x + r.w - 1;
+	int16_t y1 = r.y + r.h - 1;
+	uint32_t len = (uint32_t)r.w * (uint32_t)r.h;
+	if( (r.x != _win_x0) || (x1 != _win_x1) )
+	{
+		setColumns(r.x, x1);
+		_win_x0 = r.x;
+		_win_x1 = x1;
+		DISPLAY_COUNT(bytes, DISPLAY_CASET_BYTES);
+	}
+	if( (r.y != _win_y0) || (y1 != _win_y1) )
+	{
+		setRows(r.y, y1);
+		_win_y0 = r.y;
+		_win_y1 = y1;
+		DISPLAY_COUNT(bytes, DISPLAY_PASET_BYTES);
+	}
+	writeColor(color, len);
+	DISPLAY_COUNT(bytes, DISPLAY_RAMWR_BYTES + 2 * len);
+	DISPLAY_COUNT(pixels, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// sendBatch
+//
+// Sends every queued command in one transaction, or with a yield set, one
+// per command with the yield called in between outside of any
+// The window set stays valid across them, the controller keeps it
+//
+//-----------------------------------------------------------------------------
+void Display::sendBatch( void )
+{
+	if( _batch_len == 0 )
+	{
+		return;
+	}
+	startWrite();
+	DISPLAY_COUNT(transactions, 1);
+	_win_x0 = _win_x1 = _win_y0 = _win_y1 = -1;
+	for( uint8_t i = 0; i < _batch_len; i++ )
+	{
+		send(_batch[i].r, _batch[i].color);
+		if( (_yield != NULL) && (i + 1 < _batch_len) )
+		{
+			endWrite();
+			_yield();
+			startWrite();
+			DISPLAY_COUNT(transactions, 1);
+		}
+	}
+	endWrite();
+	_batch_len = 0;
+	if( _yield != NULL )
+	{
+		_yield();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// beginBatch
+//
+// Queues drawing until the matching endBatch(), calls can be nested
+//
+//-----------------------------------------------------------------------------
+void Display::beginBatch( void )
+{
+#if DISPLAY_STATS
+	if( _batch_depth++ == 0 )
+	{
+		_batch_start = _stats;
+	}
+#else
+	_batch_depth++;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//
+// endBatch
+//
+// Sends whatever is queued once the outermost batch ends
+//
+//-----------------------------------------------------------------------------
+void Display::endBatch( void )
+{
+	if( (_batch_depth == 0) || (--_batch_depth > 0) )
+	{
+		return;
+	}
+	sendBatch();
+#if DISPLAY_STATS
+	_batch_stats.primitives = _stats.primitives - _batch_start.primitives;
+	_batch_stats.pixels = _stats.pixels - _batch_start.pixels;
+	_batch_stats.transactions = _stats.transactions -
+		_batch_start.transactions;
+	_batch_stats.bytes = _stats.bytes - _batch_start.bytes;
+	_batch_stats.drawn = _stats.drawn - _batch_start.drawn;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//
+// beginBlit
+//
+// Opens a window for blit() in its own transaction
+// The window is clipped like anything else drawn: blit() is still fed
+// every pixel of it, and drops the ones outside the clip rect
+// Anything batched is sent first so it stays underneath
+//
+//-----------------------------------------------------------------------------
+void Display::beginBlit( int16_t x, int16_t y, int16_t w, int16_t h )
+{
+	sendBatch();
+	DISPLAY_COUNT(primitives, 1);
+	startWrite();
+	DISPLAY_COUNT(transactions, 1);
+	_blit_started = false;
+	// columns of the window inside the clip rect
+	int32_t c0 = (_clip.x > x) ? _clip.x - x : 0;
+	int32_t c1 = ((int32_t)_clip.x + _clip.w < (int32_t)x + w) ?
+		(int32_t)_clip.x + _clip.w - x : w;
+	if( (c1 <= c0) || (h <= 0) )
+	{
+		// nothing shows, every pixel is dropped
+		_blit_w = 1;
+		_blit_rows = 0;
+		return;
+	}
+	setColumns(x + c0, x + c1 - 1);
+	_win_x0 = x + c0;
+	_win_x1 = x + c1 - 1;
+	DISPLAY_COUNT(bytes, DISPLAY_CASET_BYTES);
+	bool inside = (c0 == 0) && (c1 == w) && (y >= _clip.y) &&
+		((int32_t)y + h <= (int32_t)_clip.y + _clip.h);
+	if( inside && ((_scroll_h == 0) || (y + h <= _scroll_top)) )
+	{
+		setRows(y, y + h - 1);
+		_win_y0 = y;
+		_win_y1 = y + h - 1;
+		DISPLAY_COUNT(bytes, DISPLAY_PASET_BYTES);
+		_blit_w = 0;
+		return;
+	}
+	// clipped or content rows, so row by row
+	_blit_w = w;
+	_blit_y = y;
+	_blit_rows = h;
+	_blit_left = w;
+	_blit_row = -1;
+	_blit_x0 = c0;
+	_blit_x1 = c1;
+	blitRow();
+}
+
+//-----------------------------------------------------------------------------
+//
+// blitRow
+//
+// Starts row _blit_y of a blit, a new memory write is only needed when it
+// doesn't follow on from the row before in memory
+//
+//-----------------------------------------------------------------------------
+void Display::blitRow( void )
+{
+	int16_t m = -1;
+	if( (_blit_y >= _clip.y) &&
+		((int32_t)_blit_y < (int32_t)_clip.y + _clip.h) )
+	{
+		m = toMemory(_blit_y);
+	}
+	if( (m >= 0) && ((_blit_row < 0) || (m != _blit_row + 1)) )
+	{
+		setRows(m, _height - 1);
+		_win_y0 = m;
+		_win_y1 = _height - 1;
+		DISPLAY_COUNT(bytes, DISPLAY_PASET_BYTES);
+		_blit_started = false;
+	}
+	_blit_row = m;
+}
+
+//-----------------------------------------------------------------------------
+//
+// toMemory
+//
+// Memory row of a row, -1 when it doesn't show
+//
+//-----------------------------------------------------------------------------
+int16_t Display::toMemory( int16_t y )
+{
+	if( (_scroll_h == 0) || (y < _scroll_top) )
+	{
+		return ((y >= 0) && (y < _height)) ? y : -1;
+	}
+	int32_t row = (int32_t)y - _scroll_top - _scroll;
+	if( (row < 0) || (row >= _scroll_h) )
+	{
+		return -1;
+	}
+	return _scroll_top + ((int32_t)y - _scroll_top) % _scroll_h;
+}
+
+//-----------------------------------------------------------------------------
+//
+// blit
+//
+// Writes the next len pixels of the window in one color
+//
+//-----------------------------------------------------------------------------
+void Display::blit( uint16_t color, uint32_t len )
+{
+	if( _blit_w == 0 )
+	{
+		writeRun(color, len);
+		return;
+	}
+	// rows and columns that don't show are skipped
+	while( (len > 0) && (_blit_rows > 0) )
+	{
+		uint32_t n = (len < _blit_left) ? len : _blit_left;
+		if( _blit_row >= 0 )
+		{
+			// the part of the run in the columns that show
+			int32_t col = _blit_w - _blit_left;
+			int32_t a = (col > _blit_x0) ? col : _blit_x0;
+			int32_t b = (col + (int32_t)n < _blit_x1) ? col + (int32_t)n :
+				_blit_x1;
+			if( a < b )
+			{
+				writeRun(color, b - a);
+			}
+		}
+		len -= n;
+		_blit_left -= n;
+		if( (_blit_left == 0) && (--_blit_rows > 0) )
+		{
+			_blit_y++;
+			_blit_left = _blit_w;
+			blitRow();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeRun
+//
+// The next len pixels of the memory write
+//
+//-----------------------------------------------------------------------------
+void Display::writeRun( uint16_t color, uint32_t len )
+{
+	if( _blit_started )
+	{
+		pushColor(color, len);
+	}
+	else
+	{
+		writeColor(color, len);
+		DISPLAY_COUNT(bytes, DISPLAY_RAMWR_BYTES);
+		_blit_started = true;
+	}
+	DISPLAY_COUNT(bytes, 2 * len);
+	DISPLAY_COUNT(pixels, len);
+	DISPLAY_COUNT(drawn, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// endBlit
+//
+//-----------------------------------------------------------------------------
+void Display::endBlit( void )
+{
+	endWrite();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawPixel
+//
+//-----------------------------------------------------------------------------
+void Display::drawPixel( int16_t x, int16_t y, uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writePixel(x, y, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawFastHLine
+//
+//-----------------------------------------------------------------------------
+void Display::drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writeRect(x, y, w, 1, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawFastVLine
+//
+//-----------------------------------------------------------------------------
+void Display::drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writeRect(x, y, 1, h, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// fillRect
+//
+//-----------------------------------------------------------------------------
+void Display::fillRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writeRect(x, y, w, h, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// fillScreen
+//
+//-----------------------------------------------------------------------------
+void Display::fillScreen( uint16_t color )
+{
+	// what shows, scrolled content included
+	fillRect(0, 0, _width, _height + _scroll, color);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setClip
+//
+// Limits drawing to a rectangle, so a damaged region can be repainted by
+// simply redrawing whatever panels overlap it
+//
+//-----------------------------------------------------------------------------
+void Display::setClip( int16_t x, int16_t y, int16_t w, int16_t h )
+{
+	int32_t x1 = (int32_t)x + w;
+	int32_t y1 = (int32_t)y + h;
+	if( x < 0 ) x = 0;
+	if( y < 0 ) y = 0;
+	if( x1 > _width ) x1 = _width;
+	if( y1 > bottom() ) y1 = bottom();
+	_clip.x = x;
+	_clip.y = y;
+	_clip.w = x1 > x ? x1 - x : 0;
+	_clip.h = y1 > y ? y1 - y : 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// clearClip
+//
+//-----------------------------------------------------------------------------
+void Display::clearClip( void )
+{
+	_clip.x = 0;
+	_clip.y = 0;
+	_clip.w = _width;
+	_clip.h = bottom();
+}
+
+//-----------------------------------------------------------------------------
+//
+// setScrollArea
+//
+// Scrolls the rows from top to the bottom of the screen, the ones above
+// stay put. Starts unscrolled, and whatever the area showed has to be
+// redrawn. A top outside the screen turns scrolling off again.
+//
+//-----------------------------------------------------------------------------
+void Display::setScrollArea( int16_t top )
+{
+	sendBatch();
+	if( (top <= 0) || (top >= _height) )
+	{
+		top = _height;
+	}
+	_scroll_top = top;
+	_scroll_h = _height - top;
+	_scroll = 0;
+	startWrite();
+	DISPLAY_COUNT(transactions, 1);
+	if( _scroll_h > 0 )
+	{
+		defineScroll(top, _scroll_h, 0);
+	}
+	else
+	{
+		defineScroll(0, _height, 0);
+	}
+	setScrollStart(top % _height);
+	DISPLAY_COUNT(bytes, DISPLAY_VSCRDEF_BYTES + DISPLAY_VSCRSADD_BYTES);
+	endWrite();
+	clearClip();
+}
+
+//-----------------------------------------------------------------------------
+//
+// scrollTo
+//
+// Shows content row top + y at the top of the scroll area, by sending the
+// start row and nothing else. The rows that came into view still show
+// what scrolled out, so the caller draws them.
+//
+//-----------------------------------------------------------------------------
+void Display::scrollTo( int16_t y )
+{
+	if( _scroll_h == 0 )
+	{
+		return;
+	}
+	if( y < 0 )
+	{
+		y = 0;
+	}
+	sendBatch();
+	_scroll = y;
+	startWrite();
+	DISPLAY_COUNT(transactions, 1);
+	setScrollStart(_scroll_top + y % _scroll_h);
+	DISPLAY_COUNT(bytes, DISPLAY_VSCRSADD_BYTES);
+	endWrite();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawRect
+//
+//-----------------------------------------------------------------------------
+void Display::drawRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writeRect(x, y, w, 1, color);
+	writeRect(x, y + h - 1, w, 1, color);
+	writeRect(x, y, 1, h, color);
+	writeRect(x + w - 1, y, 1, h, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawRoundRect
+//
+//-----------------------------------------------------------------------------
+void Display::drawRoundRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			int16_t r, uint16_t color )
+{
+	int16_t max_r = ((w < h) ? w : h) / 2;
+	if( r > max_r )
+	{
+		r = max_r;
+	}
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	// straight edges, may be empty when the corners meet
+	writeRect(x + r, y, w - 2 * r, 1, color);
+	writeRect(x + r, y + h - 1, w - 2 * r, 1, color);
+	writeRect(x, y + r, 1, h - 2 * r, color);
+	writeRect(x + w - 1, y + r, 1, h - 2 * r, color);
+	// corners
+	circleHelper(x + r, y + r, r, 1, color);
+	circleHelper(x + w - r - 1, y + r, r, 2, color);
+	circleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+	circleHelper(x + r, y + h - r - 1, r, 8, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawCircle
+//
+//-----------------------------------------------------------------------------
+void Display::drawCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writePixel(x0, y0 + r, color);
+	writePixel(x0, y0 - r, color);
+	writePixel(x0 + r, y0, color);
+	writePixel(x0 - r, y0, color);
+	circleHelper(x0, y0, r, 0xF, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// fillCircle
+//
+//-----------------------------------------------------------------------------
+void Display::fillCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color )
+{
+	DISPLAY_COUNT(primitives, 1);
+	begin();
+	writeRect(x0, y0 - r, 1, 2 * r + 1, color);
+	fillCircleHelper(x0, y0, r, 3, 0, color);
+	end();
+}
+
+//-----------------------------------------------------------------------------
+//
+// circleHelper
+//
+// Midpoint circle outline, one bit of corners per quadrant
+// 1 = top left, 2 = top right, 4 = bottom right, 8 = bottom left
+//
+//-----------------------------------------------------------------------------
+void Display::circleHelper( int16_t x0, int16_t y0, int16_t r,
+			uint8_t corners, uint16_t color )
+{
+	int16_t f = 1 - r;
+	int16_t ddf_x = 1;
+	int16_t ddf_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+
+	while( x < y )
+	{
+		if( f >= 0 )
+		{
+			y--;
+			ddf_y += 2;
+			f += ddf_y;
+		}
+		x++;
+		ddf_x += 2;
+		f += ddf_x;
+		if( corners & 4 )
+		{
+			writePixel(x0 + x, y0 + y, color);
+			writePixel(x0 + y, y0 + x, color);
+		}
+		if( corners & 2 )
+		{
+			writePixel(x0 + x, y0 - y, color);
+			writePixel(x0 + y, y0 - x, color);
+		}
+		if( corners & 8 )
+		{
+			writePixel(x0 - y, y0 + x, color);
+			writePixel(x0 - x, y0 + y, color);
+		}
+		if( corners & 1 )
+		{
+			writePixel(x0 - y, y0 - x, color);
+			writePixel(x0 - x, y0 - y, color);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// fillCircleHelper
+//
+// Filled halves of a circle as vertical lines
+// 1 = right half, 2 = left half, delta stretches the lines vertically
+//
+//-----------------------------------------------------------------------------
+void Display::fillCircleHelper( int16_t x0, int16_t y0, int16_t r,
+			uint8_t corners, int16_t delta, uint16_t color )
+{
+	int16_t f = 1 - r;
+	int16_t ddf_x = 1;
+	int16_t ddf_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+	int16_t px = x;
+	int16_t py = y;
+
+	delta++;
+	while( x < y )
+	{
+		if( f >= 0 )
+		{
+			y--;
+			ddf_y += 2;
+			f += ddf_y;
+		}
+		x++;
+		ddf_x += 2;
+		f += ddf_x;
+		// avoid drawing the same line twice
+		if( x < (y + 1) )
+		{
+			if( corners & 1 ) writeRect(x0 + x, y0 - y, 1, 2 * y + delta, color);
+			if( corners & 2 ) writeRect(x0 - x, y0 - y, 1, 2 * y + delta, color);
+		}
+		if( y != py )
+		{
+			if( corners & 1 ) writeRect(x0 + py, y0 - px, 1, 2 * px + delta, color);
+			if( corners & 2 ) writeRect(x0 - py, y0 - px, 1, 2 * px + delta, color);
+			py = y;
+		}
+		px = x;
+	}
+}
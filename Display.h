@@ -0,0 +1,246 @@
+#ifndef _display_h_
+#define _display_h_
+
+#include "PanelPort.h"
+
+// draw commands the board and framebuffer backends batch before they
+// have to be sent, 10 bytes each
+#ifndef DISPLAY_BATCH_LEN
+#ifdef __AVR__
+#define DISPLAY_BATCH_LEN 8
+#else
+#define DISPLAY_BATCH_LEN 16
+#endif
+#endif
+
+// 1 to count what's drawn for getStats(), 60 bytes a display, so off by
+// default on AVR. PANEL_STATS needs it.
+#ifndef DISPLAY_STATS
+#if defined(__AVR__) && !defined(PANEL_STATS)
+#define DISPLAY_STATS 0
+#else
+#define DISPLAY_STATS 1
+#endif
+#endif
+
+#if DISPLAY_STATS
+#define DISPLAY_COUNT(stat, n) (_stats.stat += (n))
+#else
+#define DISPLAY_COUNT(stat, n)
+#endif
+
+// bytes on the wire for the ILI9341 commands used, command byte included
+#define DISPLAY_CASET_BYTES 5
+#define DISPLAY_PASET_BYTES 5
+#define DISPLAY_RAMWR_BYTES 1
+#define DISPLAY_VSCRDEF_BYTES 7
+#define DISPLAY_VSCRSADD_BYTES 3
+
+//*****************************************************************************
+//
+// Display class
+//
+// Everything Panel draws goes through here. The shapes are rasterized in
+// this class (same algorithms as Adafruit_GFX) down to clipped, filled
+// rectangles, so a backend only has to know how to set the column and row
+// range and stream a color into it, the same way the ILI9341 is written to.
+// That keeps the pixels identical between the board and the host
+// framebuffer, and gives one place to count what was drawn.
+//
+// Between beginBatch() and endBatch() rectangles are queued instead of
+// sent. Each one is merged into an earlier command when it continues it in
+// the same color, and the queue goes out in a single SPI transaction,
+// resending the column or row range only when it actually changes.
+// The queue is the backend's, given to the constructor. One without it,
+// e.g. a capture into RAM, sends every rectangle as it comes.
+//
+// A blit is the other way around: one window and one memory write, fed
+// runs of color in row order, e.g. a whole page from a cached image.
+//
+// The rows from setScrollArea() down can be scrolled by the controller.
+// Drawing then addresses content rather than the screen below the top of
+// the area: content row y shows scrollTo() rows higher up, and whatever
+// isn't showing is clipped. The area's memory is used as a ring, so a
+// scroll only sends the start row, and only the rows it brings into view
+// have to be drawn. Touches are turned into content rows by toContent().
+//
+//*****************************************************************************
+struct Rect
+{
+	int16_t x, y, w, h;
+};
+
+struct DisplayStats
+{
+	uint32_t primitives; // calls to the public drawing functions
+	uint32_t pixels; // pixels actually written, after clipping
+	// pixels asked for after clipping, before the batch merges them
+	uint32_t drawn;
+	uint32_t transactions; // chip select / SPI transaction cycles
+	uint32_t bytes; // command, address and pixel bytes sent
+};
+
+struct DrawCommand
+{
+	Rect r;
+	uint16_t color;
+};
+
+class Display
+{
+	private:
+		int16_t _width, _height;
+		// everything is clipped to this, the whole screen by default
+		Rect _clip;
+#if DISPLAY_STATS
+		DisplayStats _stats;
+		DisplayStats _batch_start;
+		DisplayStats _batch_stats;
+#endif
+		// queue lent by the backend, NULL for none, the commands in it
+		// and its size, nesting depth of beginBatch()
+		DrawCommand *_batch;
+		uint8_t _batch_len;
+		uint8_t _batch_max;
+		uint8_t _batch_depth;
+		void (*_yield)(void);
+		// column and row range last sent, -1 when unknown
+		int16_t _win_x0, _win_x1, _win_y0, _win_y1;
+		// a blit has started its memory write
+		bool _blit_started;
+		// clipped blits, and any with a scroll area, are written a row at
+		// a time: the window's width, 0 when it isn't, the row being
+		// written and the rows left, the pixels left in the row, the
+		// memory row it goes to, -1 when it doesn't show, and the columns
+		// of the window that show, from _blit_x0 up to _blit_x1
+		int16_t _blit_w, _blit_y, _blit_rows;
+		uint16_t _blit_left;
+		int16_t _blit_row;
+		int16_t _blit_x0, _blit_x1;
+		// scroll area from _scroll_top to the bottom, _scroll_h is 0 when
+		// there isn't one, _scroll is the content row at its top less
+		// _scroll_top
+		int16_t _scroll_top, _scroll_h, _scroll;
+		void begin( void );
+		void end( void );
+		void writeRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color );
+		void writeClipped( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color );
+		int16_t toMemory( int16_t y );
+		// rows below this can't be drawn, with a scroll area they're
+		// content rows, so only the area's height limits what shows
+		inline int16_t bottom( void ){
+			return (_scroll_h > 0) ? 0x7fff : _height; }
+		void blitRow( void );
+		void writeRun( uint16_t color, uint32_t len );
+		void queue( const Rect &r, uint16_t color );
+		void send( const Rect &r, uint16_t color );
+		void sendBatch( void );
+		inline void writePixel( int16_t x, int16_t y, uint16_t color )
+			{ writeRect(x, y, 1, 1, color); }
+		void circleHelper( int16_t x0, int16_t y0, int16_t r,
+			uint8_t corners, uint16_t color );
+		void fillCircleHelper( int16_t x0, int16_t y0, int16_t r,
+			uint8_t corners, int16_t delta, uint16_t color );
+
+	protected:
+		// backend interface, one function per controller command
+		// writes always happen between startWrite() and endWrite(), and the
+		// ranges are inclusive and already clipped to the screen
+		virtual void startWrite( void ) {}
+		virtual void endWrite( void ) {}
+		virtual void setColumns( uint16_t x0, uint16_t x1 ) = 0;
+		virtual void setRows( uint16_t y0, uint16_t y1 ) = 0;
+		// starts a memory write at the top left of the window
+		virtual void writeColor( uint16_t color, uint32_t len ) = 0;
+		// carries on the memory write from where the last one stopped
+		virtual void pushColor( uint16_t color, uint32_t len ) = 0;
+		// vertical scroll definition and start address, top, h and bottom
+		// add up to the height, y is the memory row shown at the top
+		virtual void defineScroll( uint16_t top, uint16_t h,
+			uint16_t bottom ) {}
+		virtual void setScrollStart( uint16_t y ) {}
+
+	public:
+		Display( int16_t w, int16_t h, DrawCommand *batch = NULL,
+			uint8_t batch_max = 0 );
+		virtual ~Display() {}
+		void drawPixel( int16_t x, int16_t y, uint16_t color );
+		void drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color );
+		void drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color );
+		void fillRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color );
+		void fillScreen( uint16_t color );
+		void setClip( int16_t x, int16_t y, int16_t w, int16_t h );
+		void clearClip( void );
+		void beginBatch( void );
+		void endBatch( void );
+		void beginBlit( int16_t x, int16_t y, int16_t w, int16_t h );
+		void blit( uint16_t color, uint32_t len );
+		void endBlit( void );
+		void setScrollArea( int16_t top );
+		void scrollTo( int16_t y );
+		void drawRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			uint16_t color );
+		void drawRoundRect( int16_t x, int16_t y, int16_t w, int16_t h,
+			int16_t r, uint16_t color );
+		void drawCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color );
+		void fillCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color );
+		// inline functions
+		inline int16_t width( void ){ return _width; }
+		inline int16_t height( void ){ return _height; }
+		inline const Rect& getClip( void ){ return _clip; }
+		inline int16_t getScroll( void ){ return _scroll; }
+		inline int16_t getScrollTop( void ){ return _scroll_top; }
+		inline bool isScrolling( void ){ return _scroll_h > 0; }
+		// content row under a screen row
+		inline int16_t toContent( int16_t y ){
+			return ((_scroll_h > 0) && (y >= _scroll_top)) ? y + _scroll : y; }
+#if DISPLAY_STATS
+		inline const DisplayStats& getStats( void ){ return _stats; }
+		inline void resetStats( void ){ _stats.primitives = 0;
+			_stats.pixels = 0; _stats.transactions = 0; _stats.bytes = 0;
+			_stats.drawn = 0; }
+		// what the last outermost batch cost
+		inline const DisplayStats& getBatchStats( void ){ return _batch_stats; }
+#endif
+		// called between the commands of a batch as it's sent, so long
+		// redraws don't starve things like touch sampling. The display's
+		// transaction is ended first, so the yield can use the bus or
+		// another one (e.g. an I2C touch read), but must not draw.
+		inline void setYield( void (*yield)(void) ){ _yield = yield; }
+};
+
+//*****************************************************************************
+//
+// TouchInput class
+//
+// Source of touch samples in screen coordinates
+//
+//*****************************************************************************
+struct TouchPoint
+{
+	uint16_t x;
+	uint16_t y;
+	uint32_t t; // millis() when the sample was taken
+	// the points read in one poll come one after the other, one per
+	// finger: id counts them from 0 and count says how many there were
+	uint8_t id;
+	uint8_t count;
+};
+
+class TouchInput
+{
+	public:
+		virtual ~TouchInput() {}
+		// fills up to max points, returns how many were read
+		// returns 0 when the screen isn't being touched
+		// a poll with two fingers down gives two points, see TouchPoint
+		virtual uint8_t read( TouchPoint *points, uint8_t max ) = 0;
+		// true when read() returning 0 only means nothing new came in, so
+		// the touch has to be timed out instead of ending right away
+		virtual bool isBuffered( void ){ return false; }
+};
+
+#endif // _display_h_
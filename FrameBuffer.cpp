@@ -0,0 +1,208 @@
+#include "FrameBuffer.h"
+
+#ifndef ARDUINO
+
+#include <stdio.h>
+
+//*****************************************************************************
+//
+// FrameBufferDisplay class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+FrameBufferDisplay::FrameBufferDisplay( void ) :
+			Display(FB_WIDTH, FB_HEIGHT, _commands, DISPLAY_BATCH_LEN)
+{
+	clear();
+	setColumns(0, FB_WIDTH - 1);
+	setRows(0, FB_HEIGHT - 1);
+	_cur_x = 0;
+	_cur_y = 0;
+	defineScroll(0, FB_HEIGHT, 0);
+	setScrollStart(0);
+}
+
+//-----------------------------------------------------------------------------
+//
+// clear
+//
+// Fills the buffer directly, doesn't count as drawing
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::clear( uint16_t color )
+{
+	for( uint32_t i = 0; i < (uint32_t)FB_WIDTH * FB_HEIGHT; i++ )
+	{
+		_fb[i] = color;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// setColumns
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::setColumns( uint16_t x0, uint16_t x1 )
+{
+	_win_x0 = x0;
+	_win_x1 = x1;
+}
+
+//-----------------------------------------------------------------------------
+//
+// setRows
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::setRows( uint16_t y0, uint16_t y1 )
+{
+	_win_y0 = y0;
+	_win_y1 = y1;
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeColor
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::writeColor( uint16_t color, uint32_t len )
+{
+	_cur_x = _win_x0;
+	_cur_y = _win_y0;
+	pushColor(color, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// pushColor
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::pushColor( uint16_t color, uint32_t len )
+{
+	uint16_t x = _cur_x;
+	uint16_t y = _cur_y;
+	while( len-- )
+	{
+		_fb[y * FB_WIDTH + x] = color;
+		if( x++ == _win_x1 )
+		{
+			x = _win_x0;
+			y = (y == _win_y1) ? _win_y0 : y + 1;
+		}
+	}
+	_cur_x = x;
+	_cur_y = y;
+}
+
+//-----------------------------------------------------------------------------
+//
+// defineScroll, setScrollStart
+//
+// Only the top of the area and its height matter, the rest of the screen
+// shows memory as is. A start row outside the area shows it unscrolled.
+//
+//-----------------------------------------------------------------------------
+void FrameBufferDisplay::defineScroll( uint16_t top, uint16_t h,
+	uint16_t bottom )
+{
+	_scroll_top = top;
+	_scroll_h = h;
+	_scroll_start = top;
+}
+
+void FrameBufferDisplay::setScrollStart( uint16_t y )
+{
+	bool inside = (y >= _scroll_top) && (y < _scroll_top + _scroll_h);
+	_scroll_start = inside ? y : _scroll_top;
+}
+
+//-----------------------------------------------------------------------------
+//
+// savePPM
+//
+// Writes the buffer as a binary PPM so it can be looked at
+//
+//-----------------------------------------------------------------------------
+bool FrameBufferDisplay::savePPM( const char *path )
+{
+	FILE *fp = fopen(path, "wb");
+	if( fp == NULL )
+	{
+		return false;
+	}
+	fprintf(fp, "P6\n%d %d\n255\n", FB_WIDTH, FB_HEIGHT);
+	for( uint16_t y = 0; y < FB_HEIGHT; y++ )
+	{
+		for( uint16_t x = 0; x < FB_WIDTH; x++ )
+		{
+			// expand RGB565 to 8 bits per channel
+			uint16_t c = getPixel(x, y);
+			uint8_t rgb[3];
+			rgb[0] = ((c >> 11) & 0x1F) * 255 / 31;
+			rgb[1] = ((c >> 5) & 0x3F) * 255 / 63;
+			rgb[2] = (c & 0x1F) * 255 / 31;
+			fwrite(rgb, 1, 3, fp);
+		}
+	}
+	fclose(fp);
+	return true;
+}
+
+
+//*****************************************************************************
+//
+// ScriptedTouch class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+ScriptedTouch::ScriptedTouch( const TouchPoint *script, uint16_t len ) :
+			_script(script), _len(len), _pos(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+//
+// read
+//
+//-----------------------------------------------------------------------------
+uint8_t ScriptedTouch::read( TouchPoint *points, uint8_t max )
+{
+	if( (max == 0) || done() )
+	{
+		return 0;
+	}
+	if( _script[_pos].x == TOUCH_NONE )
+	{
+		_pos++;
+		return 0;
+	}
+	uint8_t n = _script[_pos].count > 1 ? _script[_pos].count : 1;
+	if( n > max )
+	{
+		n = max;
+	}
+	if( n > _len - _pos )
+	{
+		n = _len - _pos;
+	}
+	uint32_t t = millis();
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		points[i] = _script[_pos++];
+		points[i].t = t;
+		points[i].id = i;
+		points[i].count = n;
+	}
+	return n;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,90 @@
+#ifndef _frame_buffer_h_
+#define _frame_buffer_h_
+
+#include "Display.h"
+
+// host only, 150 KB of framebuffer won't fit on a board anyway
+#ifndef ARDUINO
+
+#define FB_WIDTH 240
+#define FB_HEIGHT 320
+
+//*****************************************************************************
+//
+// FrameBufferDisplay class
+//
+// In-memory 240 x 320 RGB565 display for host builds
+// Writes follow the ILI9341 memory write: pixels fill the address window left
+// to right, top to bottom, starting at the top left of the window and
+// wrapping back to it
+// Vertical scrolling is emulated too: the buffer is the controller's
+// memory, and getPixel() and savePPM() show it the way the screen would
+//
+//*****************************************************************************
+class FrameBufferDisplay: public Display
+{
+	private:
+		uint16_t _fb[FB_WIDTH * FB_HEIGHT];
+		DrawCommand _commands[DISPLAY_BATCH_LEN];
+		// address window, inclusive
+		uint16_t _win_x0, _win_x1, _win_y0, _win_y1;
+		// where the memory write carries on
+		uint16_t _cur_x, _cur_y;
+		// scroll area and the memory row shown at its top
+		uint16_t _scroll_top, _scroll_h, _scroll_start;
+
+	protected:
+		void setColumns( uint16_t x0, uint16_t x1 );
+		void setRows( uint16_t y0, uint16_t y1 );
+		void writeColor( uint16_t color, uint32_t len );
+		void pushColor( uint16_t color, uint32_t len );
+		void defineScroll( uint16_t top, uint16_t h, uint16_t bottom );
+		void setScrollStart( uint16_t y );
+
+	public:
+		FrameBufferDisplay( void );
+		void clear( uint16_t color = 0 );
+		bool savePPM( const char *path );
+		// inline functions
+		// pixel on the screen, with the scroll applied
+		inline uint16_t getPixel( int16_t x, int16_t y )
+			{ return _fb[memoryRow(y) * FB_WIDTH + x]; }
+		// the memory, not scrolled
+		inline const uint16_t* getBuffer( void ){ return _fb; }
+		// memory row shown on a screen row
+		inline uint16_t memoryRow( uint16_t y ){
+			return ((y < _scroll_top) || (y >= _scroll_top + _scroll_h)) ? y :
+			_scroll_top + (y - _scroll_top + _scroll_start - _scroll_top) %
+			_scroll_h; }
+};
+
+//*****************************************************************************
+//
+// ScriptedTouch class
+//
+// Replays a fixed list of touch samples, one poll per read()
+// A sample with x == TOUCH_NONE stands for a poll where nothing is touched
+// A sample with a count of 2 is read together with the one after it, as
+// a poll with two fingers down
+//
+//*****************************************************************************
+#define TOUCH_NONE 0xFFFF
+
+class ScriptedTouch: public TouchInput
+{
+	private:
+		const TouchPoint *_script;
+		uint16_t _len;
+		uint16_t _pos;
+
+	public:
+		ScriptedTouch( const TouchPoint *script, uint16_t len );
+		uint8_t read( TouchPoint *points, uint8_t max );
+		// inline functions
+		inline bool done( void ){ return _pos >= _len; }
+		inline void rewind( void ){ _pos = 0; }
+};
+
+#endif // ARDUINO
+
+#endif // _frame_buffer_h_
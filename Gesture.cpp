@@ -0,0 +1,148 @@
+#include "Gesture.h"
+
+//*****************************************************************************
+//
+// Gesture class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Gesture::Gesture( void )
+{
+	_down = false;
+	_held = false;
+	_release_ms = MENU_RELEASE_MS;
+	_long_press_ms = MENU_LONG_PRESS_MS;
+	_repeat_ms = MENU_REPEAT_MS;
+}
+
+//-----------------------------------------------------------------------------
+//
+// press
+//
+// Starts a touch
+//
+//-----------------------------------------------------------------------------
+void Gesture::press( const TouchPoint &p )
+{
+	_down = true;
+	_held = false;
+	_x = p.x;
+	_y = p.y;
+	_t = p.t;
+	_next_t = p.t + _long_press_ms;
+}
+
+//-----------------------------------------------------------------------------
+//
+// move
+//
+// Continues the touch, returns true if it moved
+//
+//-----------------------------------------------------------------------------
+bool Gesture::move( const TouchPoint &p )
+{
+	bool moved = (p.x != _x) || (p.y != _y);
+	_x = p.x;
+	_y = p.y;
+	_t = p.t;
+	return moved;
+}
+
+//-----------------------------------------------------------------------------
+//
+// hold
+//
+// Returns the event due at now while the touch is held: a release once
+// nothing came in for the release time, else a long press or repeat
+//
+//-----------------------------------------------------------------------------
+uint8_t Gesture::hold( uint32_t now )
+{
+	if( !_down )
+	{
+		return TOUCH_NO_EVENT;
+	}
+	if( now - _t >= _release_ms )
+	{
+		return TOUCH_RELEASE;
+	}
+	if( (int32_t)(now - _next_t) < 0 )
+	{
+		return TOUCH_NO_EVENT;
+	}
+	if( !_held && (_long_press_ms != 0) )
+	{
+		_held = true;
+		_next_t = now + _repeat_ms;
+		return TOUCH_LONG_PRESS;
+	}
+	if( _held && (_repeat_ms != 0) )
+	{
+		_next_t = now + _repeat_ms;
+		return TOUCH_REPEAT;
+	}
+	return TOUCH_NO_EVENT;
+}
+
+//-----------------------------------------------------------------------------
+//
+// gestureMatch
+//
+// Pairs the n points of one poll with the MENU_MAX_TOUCHES gestures,
+// closest pair first. finger[i] is the gesture point i continues, or
+// MENU_MAX_TOUCHES when it starts a new touch. Returns a bit per gesture
+// that got a point.
+//
+//-----------------------------------------------------------------------------
+uint8_t gestureMatch( Gesture *gestures, const TouchPoint *points,
+	uint8_t n, uint8_t *finger )
+{
+	uint8_t matched = 0;
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		finger[i] = MENU_MAX_TOUCHES;
+	}
+	while( true )
+	{
+		uint16_t best = 0xFFFF;
+		uint8_t best_i = 0;
+		uint8_t best_f = MENU_MAX_TOUCHES;
+		for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+		{
+			if( !gestures[f].isDown() || (matched & (1 << f)) )
+			{
+				continue;
+			}
+			for( uint8_t i = 0; i < n; i++ )
+			{
+				if( finger[i] != MENU_MAX_TOUCHES )
+				{
+					continue;
+				}
+				uint16_t dx = points[i].x > gestures[f].getX() ?
+					points[i].x - gestures[f].getX() :
+					gestures[f].getX() - points[i].x;
+				uint16_t dy = points[i].y > gestures[f].getY() ?
+					points[i].y - gestures[f].getY() :
+					gestures[f].getY() - points[i].y;
+				if( dx + dy < best )
+				{
+					best = dx + dy;
+					best_i = i;
+					best_f = f;
+				}
+			}
+		}
+		if( best_f == MENU_MAX_TOUCHES )
+		{
+			return matched;
+		}
+		finger[best_i] = best_f;
+		matched |= 1 << best_f;
+	}
+}
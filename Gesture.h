@@ -0,0 +1,80 @@
+#ifndef _gesture_h_
+#define _gesture_h_
+
+#include "Display.h"
+
+// gesture timing defaults in ms, see Gesture::setTiming()
+#ifndef MENU_RELEASE_MS
+#define MENU_RELEASE_MS 80
+#endif
+#ifndef MENU_LONG_PRESS_MS
+#define MENU_LONG_PRESS_MS 600
+#endif
+#ifndef MENU_REPEAT_MS
+#define MENU_REPEAT_MS 150
+#endif
+
+// fingers followed at once, the FT6206 reports up to 2
+#ifndef MENU_MAX_TOUCHES
+#define MENU_MAX_TOUCHES 2
+#endif
+
+enum TouchEvent
+{
+	TOUCH_PRESS,
+	TOUCH_MOVE,
+	TOUCH_RELEASE,
+	TOUCH_LONG_PRESS,
+	TOUCH_REPEAT,
+	// not a touch, a Snapshot put the panel back in a saved state
+	TOUCH_RESTORE,
+	TOUCH_NO_EVENT
+};
+
+//*****************************************************************************
+//
+// Gesture class
+//
+// Timing of the touch in progress
+// It only says which event is due, the menu decides who gets it
+//
+// A menu keeps one per finger. gestureMatch() works out which finger each
+// point of a poll belongs to: the controller doesn't say, so a point goes
+// to the nearest touch in progress, and the points left over are new.
+//
+//*****************************************************************************
+class Gesture
+{
+	private:
+		bool _down;
+		uint16_t _x, _y;
+		// time of the last sample
+		uint32_t _t;
+		// when the next long press or repeat is due
+		uint32_t _next_t;
+		bool _held;
+		uint16_t _release_ms, _long_press_ms, _repeat_ms;
+
+	public:
+		Gesture( void );
+		void press( const TouchPoint &p );
+		bool move( const TouchPoint &p );
+		uint8_t hold( uint32_t now );
+		// inline functions
+		inline void up( void ){ _down = false; }
+		inline bool isDown( void ){ return _down; }
+		// true when a sample at t comes too late to continue the touch
+		inline bool expired( uint32_t t ){ return _down &&
+			(t - _t >= _release_ms); }
+		inline uint16_t getX( void ){ return _x; }
+		inline uint16_t getY( void ){ return _y; }
+		// a long press or repeat time of 0 turns them off
+		inline void setTiming( uint16_t release_ms, uint16_t long_press_ms,
+			uint16_t repeat_ms ){ _release_ms = release_ms;
+			_long_press_ms = long_press_ms; _repeat_ms = repeat_ms; }
+};
+
+uint8_t gestureMatch( Gesture *gestures, const TouchPoint *points,
+	uint8_t n, uint8_t *finger );
+
+#endif // _gesture_h_
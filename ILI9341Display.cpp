@@ -0,0 +1,175 @@
+#include "ILI9341Display.h"
+
+#ifdef ARDUINO
+
+//*****************************************************************************
+//
+// ILI9341Display class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+ILI9341Display::ILI9341Display( Adafruit_ILI9341 &tft ) :
+			Display(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT, _commands,
+				DISPLAY_BATCH_LEN),
+			_tft(tft)
+{
+}
+
+//-----------------------------------------------------------------------------
+//
+// startWrite
+//
+// Selects the chip and begins the SPI transaction
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::startWrite( void )
+{
+	_tft.startWrite();
+}
+
+//-----------------------------------------------------------------------------
+//
+// endWrite
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::endWrite( void )
+{
+	_tft.endWrite();
+}
+
+//-----------------------------------------------------------------------------
+//
+// setColumns
+//
+// Column address set, the same as the first half of
+// Adafruit_ILI9341::setAddrWindow()
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::setColumns( uint16_t x0, uint16_t x1 )
+{
+	_tft.writeCommand(ILI9341_CASET);
+	_tft.SPI_WRITE16(x0);
+	_tft.SPI_WRITE16(x1);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setRows
+//
+// Page (row) address set
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::setRows( uint16_t y0, uint16_t y1 )
+{
+	_tft.writeCommand(ILI9341_PASET);
+	_tft.SPI_WRITE16(y0);
+	_tft.SPI_WRITE16(y1);
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeColor
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::writeColor( uint16_t color, uint32_t len )
+{
+	_tft.writeCommand(ILI9341_RAMWR);
+	_tft.writeColor(color, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// pushColor
+//
+// More pixel data for the memory write already going
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::pushColor( uint16_t color, uint32_t len )
+{
+	_tft.writeColor(color, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// defineScroll
+//
+// Vertical scrolling definition, fixed rows on top, scrolled rows and
+// fixed rows on the bottom, the same as
+// Adafruit_ILI9341::setScrollMargins() inside our transaction
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::defineScroll( uint16_t top, uint16_t h, uint16_t bottom )
+{
+	_tft.writeCommand(ILI9341_VSCRDEF);
+	_tft.SPI_WRITE16(top);
+	_tft.SPI_WRITE16(h);
+	_tft.SPI_WRITE16(bottom);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setScrollStart
+//
+// Vertical scrolling start address, the memory row shown at the top of
+// the scroll area
+//
+//-----------------------------------------------------------------------------
+void ILI9341Display::setScrollStart( uint16_t y )
+{
+	_tft.writeCommand(ILI9341_VSCRSADD);
+	_tft.SPI_WRITE16(y);
+}
+
+
+//*****************************************************************************
+//
+// FT6206Touch class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+FT6206Touch::FT6206Touch( Adafruit_FT6206 &ctp, bool flip ) :
+			_ctp(ctp), _flip(flip)
+{
+}
+
+//-----------------------------------------------------------------------------
+//
+// read
+//
+//-----------------------------------------------------------------------------
+uint8_t FT6206Touch::read( TouchPoint *points, uint8_t max )
+{
+	uint8_t n = _ctp.touched();
+	if( n > max )
+	{
+		n = max;
+	}
+	uint32_t t = millis();
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		TS_Point p = _ctp.getPoint(i);
+		if( _flip )
+		{
+			p.x = ILI9341_TFTWIDTH - 1 - p.x;
+			p.y = ILI9341_TFTHEIGHT - 1 - p.y;
+		}
+		points[i].x = p.x;
+		points[i].y = p.y;
+		points[i].t = t;
+		points[i].id = i;
+		points[i].count = n;
+	}
+	return n;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,64 @@
+#ifndef _ili9341_display_h_
+#define _ili9341_display_h_
+
+#include "Display.h"
+
+#ifdef ARDUINO
+
+#include <Adafruit_GFX.h>    // Core graphics library
+#include <SPI.h>       // needed for display
+#include <Adafruit_ILI9341.h>
+#include <Wire.h>      // needed for FT6206
+#include <Adafruit_FT6206.h>
+
+//*****************************************************************************
+//
+// ILI9341Display class
+//
+// Display backend for the Adafruit ILI9341 breakout
+//
+//*****************************************************************************
+class ILI9341Display: public Display
+{
+	private:
+		Adafruit_ILI9341 &_tft;
+		DrawCommand _commands[DISPLAY_BATCH_LEN];
+
+	protected:
+		void startWrite( void );
+		void endWrite( void );
+		void setColumns( uint16_t x0, uint16_t x1 );
+		void setRows( uint16_t y0, uint16_t y1 );
+		void writeColor( uint16_t color, uint32_t len );
+		void pushColor( uint16_t color, uint32_t len );
+		void defineScroll( uint16_t top, uint16_t h, uint16_t bottom );
+		void setScrollStart( uint16_t y );
+
+	public:
+		ILI9341Display( Adafruit_ILI9341 &tft );
+};
+
+//*****************************************************************************
+//
+// FT6206Touch class
+//
+// Touch backend for the FT6206 capacitive controller
+// The touch panel is mirrored relative to the display in portrait, so by
+// default points are flipped into screen coordinates
+// With two fingers down both points are read in the same poll.
+//
+//*****************************************************************************
+class FT6206Touch: public TouchInput
+{
+	private:
+		Adafruit_FT6206 &_ctp;
+		bool _flip;
+
+	public:
+		FT6206Touch( Adafruit_FT6206 &ctp, bool flip = true );
+		uint8_t read( TouchPoint *points, uint8_t max );
+};
+
+#endif // ARDUINO
+
+#endif // _ili9341_display_h_
@@ -0,0 +1,417 @@
+#include "PageManager.h"
+
+//*****************************************************************************
+//
+// PageCapture class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+PageCapture::PageCapture( int16_t w, int16_t h, uint16_t *band,
+			uint8_t rows ) :
+			Display(w, h), _band(band), _rows(rows)
+{
+	_win_x0 = _win_x1 = _win_y0 = _win_y1 = 0;
+	_cur_x = _cur_y = 0;
+	setBand(0);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setBand
+//
+// Starts rendering the rows from y, cleared to the background
+//
+//-----------------------------------------------------------------------------
+void PageCapture::setBand( int16_t y )
+{
+	_band_y = y;
+	for( uint16_t i = 0; i < (uint16_t)_rows * width(); i++ )
+	{
+		_band[i] = BG_COLOR;
+	}
+	setClip(0, y, width(), _rows);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setColumns
+//
+//-----------------------------------------------------------------------------
+void PageCapture::setColumns( uint16_t x0, uint16_t x1 )
+{
+	_win_x0 = x0;
+	_win_x1 = x1;
+}
+
+//-----------------------------------------------------------------------------
+//
+// setRows
+//
+//-----------------------------------------------------------------------------
+void PageCapture::setRows( uint16_t y0, uint16_t y1 )
+{
+	_win_y0 = y0;
+	_win_y1 = y1;
+}
+
+//-----------------------------------------------------------------------------
+//
+// writeColor
+//
+//-----------------------------------------------------------------------------
+void PageCapture::writeColor( uint16_t color, uint32_t len )
+{
+	_cur_x = _win_x0;
+	_cur_y = _win_y0;
+	pushColor(color, len);
+}
+
+//-----------------------------------------------------------------------------
+//
+// pushColor
+//
+// Everything drawn is clipped to the band, what isn't in it anyway is
+// dropped rather than written past it
+//
+//-----------------------------------------------------------------------------
+void PageCapture::pushColor( uint16_t color, uint32_t len )
+{
+	uint16_t x = _cur_x;
+	uint16_t y = _cur_y;
+	while( len-- )
+	{
+		if( (y >= _band_y) && (y < _band_y + _rows) && (x < width()) )
+		{
+			_band[(y - _band_y) * width() + x] = color;
+		}
+		if( x++ == _win_x1 )
+		{
+			x = _win_x0;
+			y = (y == _win_y1) ? _win_y0 : y + 1;
+		}
+	}
+	_cur_x = x;
+	_cur_y = y;
+}
+
+
+//*****************************************************************************
+//
+// PageManager class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// putRun
+//
+// Appends one run to a store, 1..15 pixels go in the low nibble, longer
+// ones set it to 15 and add a second byte
+//
+//-----------------------------------------------------------------------------
+static bool putRun( PageStore *pstore, uint32_t *paddr, uint8_t index,
+	uint16_t run )
+{
+	uint32_t addr = *paddr;
+	if( run < 16 )
+	{
+		*paddr += 1;
+		return (addr < pstore->size()) &&
+			pstore->write(addr, (index << 4) | (run - 1));
+	}
+	*paddr += 2;
+	return (addr + 1 < pstore->size()) &&
+		pstore->write(addr, (index << 4) | 15) &&
+		pstore->write(addr + 1, run - 16);
+}
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+PageManager::PageManager( void )
+{
+	_cached = 0;
+	_count = 0;
+	_current = PAGE_NONE;
+	_next = PAGE_NONE;
+	_updating = false;
+	_progressive = false;
+}
+
+//-----------------------------------------------------------------------------
+//
+// addPage
+//
+// Returns the page number, or PAGE_NONE when full
+// Pages with a store can be cached
+//
+//-----------------------------------------------------------------------------
+uint8_t PageManager::addPage( Menu *pmenu, PageStore *pstore )
+{
+	if( _count == PAGE_MAX )
+	{
+		return PAGE_NONE;
+	}
+	_pages[_count] = pmenu;
+	_stores[_count] = pstore;
+	return _count++;
+}
+
+//-----------------------------------------------------------------------------
+//
+// isCached
+//
+// True if the page has a cache that still matches it
+//
+//-----------------------------------------------------------------------------
+bool PageManager::isCached( uint8_t page )
+{
+	return (page < _count) && (_cached & (1 << page)) &&
+		(_versions[page] == _pages[page]->getVersion());
+}
+
+//-----------------------------------------------------------------------------
+//
+// cache
+//
+// Renders the page into its store, PAGE_BAND_ROWS rows at a time with
+// the band on the stack, or rows at a time in a band of rows times the
+// display's width lent by the caller
+// On AVR the stack peaks at the band (480 bytes for the default row), 67
+// for the capture, 32 for the palette and some 20 of locals, plus the
+// deepest drawPanel(). Lending the band leaves about 120.
+// The image is what the panels last drew, so a page with changes that
+// haven't been flushed yet isn't cached, show it first
+// Returns false if there's no writable store, the store is too small,
+// the page uses more than PAGE_COLORS colors or it isn't flushed
+//
+//-----------------------------------------------------------------------------
+bool PageManager::cache( uint8_t page )
+{
+	uint16_t band[MAX_X * PAGE_BAND_ROWS];
+	return cache(page, band, PAGE_BAND_ROWS);
+}
+
+bool PageManager::cache( uint8_t page, uint16_t *band, uint8_t rows )
+{
+	if( (page >= _count) || (_stores[page] == NULL) || (rows == 0) ||
+		!_pages[page]->isFlushed() )
+	{
+		return false;
+	}
+	_cached &= ~(1 << page);
+	PageStore *pstore = _stores[page];
+	Display *pdisplay = Panel::getDisplay();
+	int16_t w = pdisplay->width();
+	int16_t h = pdisplay->height();
+	PageCapture capture(w, h, band, rows);
+	uint16_t palette[PAGE_COLORS];
+	uint8_t colors = 0;
+	uint32_t addr = PAGE_HEADER_BYTES;
+	// run being built
+	uint8_t index = 0;
+	uint16_t run = 0;
+	bool ok = pstore->size() >= PAGE_HEADER_BYTES;
+
+	Panel::setDisplay(&capture);
+	for( int16_t y = 0; ok && (y < h); y += rows )
+	{
+		capture.setBand(y);
+		// only what the panels show, their pending renders and damage
+		// are left for the page's own flush
+		for( Panel *ppanel = _pages[page]->getHead(); ppanel != NULL;
+			ppanel = ppanel->getNext() )
+		{
+			ppanel->drawPanel();
+		}
+		for( int16_t row = 0; ok && (row < rows) &&
+			(y + row < h); row++ )
+		{
+			for( int16_t x = 0; ok && (x < w); x++ )
+			{
+				uint16_t color = capture.getPixel(x, row);
+				// most pixels continue the run
+				uint8_t i = index;
+				if( (run == 0) || (palette[i] != color) )
+				{
+					i = 0;
+					while( (i < colors) && (palette[i] != color) )
+					{
+						i++;
+					}
+				}
+				if( i == colors )
+				{
+					if( colors == PAGE_COLORS )
+					{
+						ok = false;
+						break;
+					}
+					palette[colors++] = color;
+				}
+				if( (run > 0) && ((i != index) || (run == 271)) )
+				{
+					ok = putRun(pstore, &addr, index, run);
+					run = 0;
+				}
+				index = i;
+				run++;
+			}
+		}
+	}
+	Panel::setDisplay(pdisplay);
+	if( ok && (run > 0) )
+	{
+		ok = putRun(pstore, &addr, index, run);
+	}
+	// header last, now the palette is known
+	if( ok )
+	{
+		ok = pstore->write(0, colors);
+		for( uint8_t i = 0; ok && (i < colors); i++ )
+		{
+			ok = pstore->write(1 + 2 * i, palette[i] & 0xFF) &&
+				pstore->write(2 + 2 * i, palette[i] >> 8);
+		}
+		ok = ok && pstore->write(1 + 2 * PAGE_COLORS, w & 0xFF) &&
+			pstore->write(2 + 2 * PAGE_COLORS, w >> 8) &&
+			pstore->write(3 + 2 * PAGE_COLORS, h & 0xFF) &&
+			pstore->write(4 + 2 * PAGE_COLORS, h >> 8);
+	}
+	if( ok )
+	{
+		_cached |= 1 << page;
+		_versions[page] = _pages[page]->getVersion();
+	}
+	return ok;
+}
+
+//-----------------------------------------------------------------------------
+//
+// blit
+//
+// Decodes a cached page straight onto the screen, runs of the same color
+// are joined up so each color change is one write
+//
+//-----------------------------------------------------------------------------
+void PageManager::blit( PageStore *pstore )
+{
+	Display *pdisplay = Panel::getDisplay();
+	uint16_t palette[PAGE_COLORS];
+	uint8_t colors = pstore->read(0);
+	for( uint8_t i = 0; i < colors; i++ )
+	{
+		palette[i] = pstore->read(1 + 2 * i) |
+			(pstore->read(2 + 2 * i) << 8);
+	}
+	int16_t w = pstore->read(1 + 2 * PAGE_COLORS) |
+		(pstore->read(2 + 2 * PAGE_COLORS) << 8);
+	int16_t h = pstore->read(3 + 2 * PAGE_COLORS) |
+		(pstore->read(4 + 2 * PAGE_COLORS) << 8);
+	uint32_t left = (uint32_t)w * h;
+	uint32_t addr = PAGE_HEADER_BYTES;
+	uint16_t color = 0;
+	uint32_t run = 0;
+	pdisplay->beginBlit(0, 0, w, h);
+	while( left > 0 )
+	{
+		uint8_t b = pstore->read(addr++);
+		uint16_t len = (b & 15) + 1;
+		if( len == 16 )
+		{
+			len = 16 + pstore->read(addr++);
+		}
+		uint16_t next = palette[b >> 4];
+		if( (run > 0) && (next != color) )
+		{
+			pdisplay->blit(color, run);
+			run = 0;
+		}
+		color = next;
+		run += len;
+		left -= len;
+	}
+	pdisplay->blit(color, run);
+	pdisplay->endBlit();
+}
+
+//-----------------------------------------------------------------------------
+//
+// change
+//
+// Puts a page on the screen
+// A progressive page is only cleared here, update() draws the panels
+//
+//-----------------------------------------------------------------------------
+void PageManager::change( uint8_t page )
+{
+	_current = page;
+	if( isCached(page) )
+	{
+		blit(_stores[page]);
+	}
+	else
+	{
+		Panel::getDisplay()->fillScreen(BG_COLOR);
+		if( _progressive )
+		{
+			_pages[page]->paintMenu();
+		}
+		else
+		{
+			_pages[page]->drawMenu();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// show
+//
+// Switches to a page
+// From inside a panel's method the switch waits until the current page's
+// update() has finished, so nothing of it gets drawn over the new page
+//
+//-----------------------------------------------------------------------------
+void PageManager::show( uint8_t page )
+{
+	if( page >= _count )
+	{
+		return;
+	}
+	if( _updating )
+	{
+		_next = page;
+		return;
+	}
+	change(page);
+}
+
+//-----------------------------------------------------------------------------
+//
+// update
+//
+// Handles touches on the current page, call from loop()
+//
+//-----------------------------------------------------------------------------
+void PageManager::update( void )
+{
+	if( _current != PAGE_NONE )
+	{
+		_updating = true;
+		_pages[_current]->update();
+		_updating = false;
+	}
+	if( _next != PAGE_NONE )
+	{
+		change(_next);
+		_next = PAGE_NONE;
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef _page_manager_h_
+#define _page_manager_h_
+
+#include "Panel.h"
+#include "PageStore.h"
+
+// most pages a manager holds
+#ifndef PAGE_MAX
+#define PAGE_MAX 4
+#endif
+#if PAGE_MAX > 8
+#error "PAGE_MAX can't be more than 8"
+#endif
+
+// rows rendered per pass by cache() with its band on the stack, each costs
+// 2 bytes per column, and every pass draws the whole page once: with 1 row
+// caching a 320 row page draws it 320 times, with 8 rows (3840 bytes) 40
+// cache() can be lent a bigger band to take fewer passes
+#ifndef PAGE_BAND_ROWS
+#define PAGE_BAND_ROWS 1
+#endif
+
+// colors a cached page can use
+#define PAGE_COLORS 16
+
+// bytes in front of the runs: color count, palette, width and height
+#define PAGE_HEADER_BYTES (1 + 2 * PAGE_COLORS + 4)
+
+#define PAGE_NONE 0xFF
+
+//*****************************************************************************
+//
+// PageCapture class
+//
+// Display that renders into a band of rows in RAM instead of a screen,
+// used to cache a page a band at a time without a full framebuffer
+// The band is lent by the caller, rows times the width pixels
+// It has no batch queue, writes into RAM gain nothing from one, so on AVR
+// it takes 67 bytes
+//
+//*****************************************************************************
+class PageCapture: public Display
+{
+	private:
+		uint16_t *_band;
+		uint8_t _rows;
+		int16_t _band_y;
+		uint16_t _win_x0, _win_x1, _win_y0, _win_y1;
+		uint16_t _cur_x, _cur_y;
+
+	protected:
+		void setColumns( uint16_t x0, uint16_t x1 );
+		void setRows( uint16_t y0, uint16_t y1 );
+		void writeColor( uint16_t color, uint32_t len );
+		void pushColor( uint16_t color, uint32_t len );
+
+	public:
+		PageCapture( int16_t w, int16_t h, uint16_t *band, uint8_t rows );
+		void setBand( int16_t y );
+		// inline functions
+		inline uint16_t getPixel( int16_t x, int16_t row )
+			{ return _band[row * width() + x]; }
+};
+
+//*****************************************************************************
+//
+// PageManager class
+//
+// Switches the screen between several Menus
+//
+// A page given a PageStore can be cached: rendered once into the store as
+// a run length encoded image (a 16 color palette, then one byte per run of
+// up to 15 pixels or two for up to 271). Showing a cached page is then a
+// single window and one memory write of the whole screen, however many
+// panels it has, instead of clearing the screen and drawing every panel.
+//
+// The cache is only used while nothing on the page has changed since it
+// was made, going by Menu::getVersion(), which also counts panels changed
+// from code.
+//
+//*****************************************************************************
+class PageManager
+{
+	private:
+		Menu *_pages[PAGE_MAX];
+		PageStore *_stores[PAGE_MAX];
+		// menu version each cache was made at
+		uint32_t _versions[PAGE_MAX];
+		// bit i is set if page i has a cache
+		uint8_t _cached;
+		uint8_t _count;
+		uint8_t _current;
+		// page to switch to once the current page's update is done
+		uint8_t _next;
+		bool _updating;
+		// pages that aren't cached are drawn with paintMenu()
+		bool _progressive;
+		void blit( PageStore *pstore );
+		void change( uint8_t page );
+
+	public:
+		PageManager( void );
+		uint8_t addPage( Menu *pmenu, PageStore *pstore = NULL );
+		bool cache( uint8_t page );
+		bool cache( uint8_t page, uint16_t *band, uint8_t rows );
+		void show( uint8_t page );
+		void update( void );
+		bool isCached( uint8_t page );
+		// inline functions
+		inline uint8_t getCount( void ){ return _count; }
+		inline uint8_t getCurrent( void ){ return _current; }
+		inline Menu* getPage( uint8_t page ){ return _pages[page]; }
+		inline bool getProgressive( void ){ return _progressive; }
+		inline void setProgressive( bool on ){ _progressive = on; }
+};
+
+#endif // _page_manager_h_
@@ -0,0 +1,67 @@
+#ifndef _page_store_h_
+#define _page_store_h_
+
+#include "PanelPort.h"
+
+//*****************************************************************************
+//
+// PageStore class
+//
+// Somewhere a cached page image can be kept, addressed byte by byte
+// Anything else (SPI flash, an SD card file...) can be used by deriving
+// from this. Stores that can only be read return false from write().
+//
+//*****************************************************************************
+class PageStore
+{
+	public:
+		virtual ~PageStore() {}
+		virtual uint32_t size( void ) = 0;
+		virtual uint8_t read( uint32_t addr ) = 0;
+		virtual bool write( uint32_t addr, uint8_t b ){ return false; }
+};
+
+//*****************************************************************************
+//
+// RamStore class
+//
+// Image kept in a buffer in RAM
+//
+//*****************************************************************************
+class RamStore: public PageStore
+{
+	private:
+		uint8_t *_buf;
+		uint32_t _size;
+
+	public:
+		RamStore( uint8_t *buf, uint32_t size ) : _buf(buf), _size(size) {}
+		uint32_t size( void ){ return _size; }
+		uint8_t read( uint32_t addr ){ return _buf[addr]; }
+		bool write( uint32_t addr, uint8_t b ){ _buf[addr] = b; return true; }
+		// inline functions
+		inline const uint8_t* getBuffer( void ){ return _buf; }
+};
+
+//*****************************************************************************
+//
+// ProgmemStore class
+//
+// Image built into flash, e.g. cached into a RamStore by a host build of
+// the same page, and its bytes pasted into the sketch as a PROGMEM array
+//
+//*****************************************************************************
+class ProgmemStore: public PageStore
+{
+	private:
+		const uint8_t *_data;
+		uint32_t _size;
+
+	public:
+		ProgmemStore( const uint8_t *data, uint32_t size ) :
+			_data(data), _size(size) {}
+		uint32_t size( void ){ return _size; }
+		uint8_t read( uint32_t addr ){ return pgm_read_byte_near(_data + addr); }
+};
+
+#endif // _page_store_h_
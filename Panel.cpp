@@ -1,30 +1,22 @@
 #include "Panel.h"
 
+#ifdef ARDUINO
 // The FT6206 uses hardware I2C (SCL/SDA)
 Adafruit_FT6206 ctp = Adafruit_FT6206(); 
 
 Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC); 
 
-// arc sine array
-const PROGMEM uint8_t asin21[] = { 0, 18, 26, 32, 37, 42, 46, 51, 55, 59, 63, 
-	67, 71, 75, 80, 84, 89, 94, 100, 108, 127 };
+ILI9341Display tftDisplay = ILI9341Display(tft);
+FT6206Touch ctpTouch = FT6206Touch(ctp);
 
-// arc cos array 
-const PROGMEM uint8_t acos21[] = {255, 218, 202, 190, 179, 170, 160, 152, 
-	143, 135, 127, 119, 111, 102, 94, 85, 75, 64, 52, 36, 0};
+Display *Panel::_display = &tftDisplay;
+#else
+Display *Panel::_display = NULL;
+#endif // ARDUINO
 
-// sine array
-// note that index of asin21 lines up with index of sin21, cos21
-// 		for -pi/2 <= i <= pi/2
-// 		e.g., sin21, cos21 only have half of period, the part used for 
-const PROGMEM uint8_t sin21[] = { 0, 6, 12, 19, 24, 31, 37, 44, 50, 56, 63, 69,
-	75, 81, 89, 95, 101, 107, 114, 121, 128 };
-// cos array
-const PROGMEM uint8_t cos21[] = { 64, 91, 102, 109, 114, 119, 122, 124, 126, 
-	127, 127, 127, 126, 125, 122, 119, 115, 110, 103, 92, 64 };
-
-// length of array
-const uint8_t TRIG_LEN = 21;
+uint8_t Panel::_event = TOUCH_PRESS;
+CallbackQueue *Panel::_queue = NULL;
+Menu *Menu::_menus[MENU_MAX_MENUS + 1];
 
 //*****************************************************************************
 //
@@ -39,11 +31,17 @@ const uint8_t TRIG_LEN = 21;
 //-----------------------------------------------------------------------------
 Panel::Panel( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel) ) :
-			_x(x), _y(y), _w(w), _h(h), _method(method)
+			_method(method), _y(y), _h(h), _x(x), _w(w)
 {
 	_next 	= NULL;
 	_child 	= NULL;
+	_menu	= 0;
 	_enable	= true;
+	_pending = false;
+	_unpainted = false;
+#ifdef PANEL_STATS
+	resetStats();
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -53,7 +51,7 @@ Panel::Panel( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 //-----------------------------------------------------------------------------
 Panel::~Panel()
 {
-	tft.fillRect(_x, _y, _w, _h, BG_COLOR);
+	_display->fillRect(_x, _y, _w, _h, BG_COLOR);
 }
 
 //-----------------------------------------------------------------------------
@@ -65,12 +63,8 @@ Panel::~Panel()
 //-----------------------------------------------------------------------------
 bool Panel::isTouched( uint16_t x, uint16_t y )
 {
-	if( !_enable )
-	{
-		return false;
-	}
 	// if it is within the range of the panel
-	if( (x >= _x) && (x < _x + _w) && (y >= _y) && (y < _y+ _h))
+	if( contains(x, y) )
 	{
 		//(*_method)(x, y, this);
 		updatePanel(x, y);
@@ -80,174 +74,175 @@ bool Panel::isTouched( uint16_t x, uint16_t y )
 		return false;
 }
 
-
-//*****************************************************************************
-//
-// Button class
-//
-//*****************************************************************************
-
 //-----------------------------------------------------------------------------
 // 
-// Constructor
+// handleEvent
+//
+// By default panels follow the finger while it's down and on them
 //
 //-----------------------------------------------------------------------------
-Button::Button( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
-			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
-			uint16_t color ) :
-			Panel(x, y, w, h, method),
-			_color(color)
+void Panel::handleEvent( uint8_t event, uint16_t x, uint16_t y )
 {
-	_state = false;
+	if( ((event == TOUCH_PRESS) || (event == TOUCH_MOVE)) && contains(x, y) )
+	{
+		updatePanel(x, y);
+	}
 }
+
+#ifdef PANEL_STATS
 //-----------------------------------------------------------------------------
 // 
-// drawPanel
+// draw
 //
-// Draws button on screen
+// drawPanel(), counted
 //
 //-----------------------------------------------------------------------------
-void Button::drawPanel( void )
+void Panel::draw( void )
 {
-	// don't need edges of button to be filled
-	tft.fillRect(_x+1, _y+1, _w-1, _h-1, _color);
-	tft.drawRect(_x, _y, _w, _h, BG_COLOR);
+	uint32_t drawn = _display->getStats().drawn;
+	drawPanel();
+	_stats.draws++;
+	_stats.pixels += _display->getStats().drawn - drawn;
 }
 
 //-----------------------------------------------------------------------------
 // 
-// updatePanel
+// redraw
 //
-// Draws button on screen
+// render(), counted and timed
 //
 //-----------------------------------------------------------------------------
-void Button::updatePanel( uint16_t x, uint16_t y)
+void Panel::redraw( void )
 {
-	// button pressing requires delay, otherwise would constantly be switching
-	unsigned long _current_millis = millis();
-	if(_current_millis < _old_millis + 400)
-	{
-		return;
-	}
-	_old_millis = _current_millis;
-	// call bound method
-	(*_method)(x, y, this);
-	// toggle button
-	_state = !_state;
-	if ( _state )
-	{
-		tft.drawRect(_x, _y, _w, _h, FG_COLOR3);
-	}
-	else
-	{
-		tft.drawRect(_x, _y, _w, _h, BG_COLOR);
-	}	
-
+	uint32_t drawn = _display->getStats().drawn;
+	uint32_t start = micros();
+	render();
+	_stats.update_us += (uint32_t)micros() - start;
+	_stats.pixels += _display->getStats().drawn - drawn;
 }
 
-
-//*****************************************************************************
+//-----------------------------------------------------------------------------
+// 
+// handle
 //
-// Fader class
+// handleEvent(), timed without the bound method
 //
-//*****************************************************************************
+//-----------------------------------------------------------------------------
+void Panel::handle( uint8_t event, uint16_t x, uint16_t y )
+{
+	uint32_t method_us = _stats.method_us;
+	uint32_t start = micros();
+	handleEvent(event, x, y);
+	_stats.events++;
+	_stats.update_us += (uint32_t)micros() - start -
+		(_stats.method_us - method_us);
+}
 
 //-----------------------------------------------------------------------------
 // 
-// Constructor
+// runMethod
+//
+// Calls the bound method, timed
 //
 //-----------------------------------------------------------------------------
-Fader::Fader( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
-			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
-			uint16_t color ) :
-			Panel(x, y, w, h, method),
-			_color(color)
+bool Panel::runMethod( uint16_t x, uint16_t y )
 {
-	_value = _x + _border; // maybe should be x instead of 0?
-	_old_val = _value;
-	_y_dim = h - 2 * _border;
-	_min = _x_dim/2 + _border;
-	_max = MAX_X - (_x_dim/2 + _border);
+	uint32_t start = micros();
+	bool ret = (*_method)(x, y, this);
+	_stats.method_us += (uint32_t)micros() - start;
+	return ret;
 }
+#endif // PANEL_STATS
 
 //-----------------------------------------------------------------------------
 // 
-// drawPanel
+// markDirty
+//
+// Marks part of the panel to be repainted by drawPanel()
+// Outside of a Menu there is nothing to collect it, so it's repainted now
 //
 //-----------------------------------------------------------------------------
-
-//!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-// FIX ME has issues when _x != 0, when length is not maxx
-//!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-void Fader::drawPanel( void )
+void Panel::markDirty( int16_t x, int16_t y, int16_t w, int16_t h )
 {
-	// draw fader track
-	tft.drawFastHLine(_min, _y + _h/3, _max - _min, FG_COLOR1);
-	tft.drawFastHLine(_min, _y + 2*_h/3, _max - _min, FG_COLOR1);
-	// draw fader
-	tft.drawRect(_value, _y + _border, _x_dim, _y_dim, _color);
-	// "erase" track where fader is	
-	tft.drawFastHLine(_value + 1, _y + _h/3, _x_dim - 2 , BG_COLOR);
-	tft.drawFastHLine(_value + 1, _y + 2*_h/3, _x_dim - 2, BG_COLOR);
+	Menu *pmenu = menu();
+	if( pmenu != NULL )
+	{
+		pmenu->_damage.add(x, y, w, h);
+		pmenu->_version++;
+		return;
+	}
+	_display->beginBatch();
+	_display->setClip(x, y, w, h);
+	_display->fillRect(x, y, w, h, BG_COLOR);
+	draw();
+	_display->clearClip();
+	_display->endBatch();
 }
 
 //-----------------------------------------------------------------------------
 // 
-// updatePanel
+// overlapped
+//
+// True when another panel of the menu overlaps r
 //
 //-----------------------------------------------------------------------------
-void Fader::updatePanel( uint16_t x, uint16_t y )
+bool Panel::overlapped( const Rect &r )
 {
-	// determine where track should be drawn in after being covered by fader
-	// does not go below bottom of track
-	uint16_t track_min = _old_val > _min ? _old_val : _min;
-	uint16_t track_w;
-	// call bound method
-	(*_method)(x, y, this);
-	// does not go above top of track
-	if( track_min + _x_dim < _max )
-	{
-		track_w = _x_dim;
-	}
-	else
+	Menu *pmenu = menu();
+	if( pmenu == NULL )
 	{
-		track_w = _max - track_min;
+		return false;
 	}
-	// want to make sure everything stays on screen
-	if(x > _min)
+	for( Panel *ppanel = pmenu->_head; ppanel != NULL; ppanel = ppanel->_next )
 	{
-		if( x < _max )
-		{
-			_value = x - _x_dim/2;
-		}
-		else
+		if( (ppanel != this) && ppanel->intersects(r) )
 		{
-			_value = MAX_X - _x_dim - _border;
+			return true;
 		}
 	}
-	else
-	{
-		_value = _border;
-	}
-
+	return false;
+}
 
-	// erase previous rect
-	tft.drawRect(_old_val, _y + _border, _x_dim, _y_dim, BG_COLOR);
-	// fill in lines / erase line inside fader
-	tft.drawFastHLine(track_min, _y + _h/3, track_w, FG_COLOR1);
-	tft.drawFastHLine(track_min, _y + 2*_h/3, track_w, FG_COLOR1);
-	tft.drawFastHLine(_value, _y + _h/3, _x_dim, BG_COLOR);
-	tft.drawFastHLine(_value, _y + 2*_h/3, _x_dim, BG_COLOR);
-	// Draw new fader
-	tft.drawRect(_value, _y + _border, _x_dim, _y_dim, _color);
+//-----------------------------------------------------------------------------
+// 
+// repaint
+//
+// Clears r and redraws the menu's panels clipped to it, for overlapped()
+// regions
+//
+//-----------------------------------------------------------------------------
+void Panel::repaint( const Rect &r )
+{
+	menu()->repaint(r);
+}
 
-	_old_val = _value;
+//-----------------------------------------------------------------------------
+// 
+// markPending
+//
+// Has render() called when the menu flushes, once however many events
+// asked for it
+// Outside of a Menu there is nothing to collect it, so it's rendered now
+//
+//-----------------------------------------------------------------------------
+void Panel::markPending( void )
+{
+	Menu *pmenu = menu();
+	if( pmenu != NULL )
+	{
+		_pending = true;
+		pmenu->_version++;
+		return;
+	}
+	_display->beginBatch();
+	redraw();
+	_display->endBatch();
 }
 
 
 //*****************************************************************************
 //
-// Sketch class
+// Button class
 //
 //*****************************************************************************
 
@@ -256,35 +251,47 @@ void Fader::updatePanel( uint16_t x, uint16_t y )
 // Constructor
 //
 //-----------------------------------------------------------------------------
-Sketch::Sketch( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+Button::Button( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color ) :
 			Panel(x, y, w, h, method),
 			_color(color)
 {
+	_state = false;
+	_repeat = false;
 }
-
 //-----------------------------------------------------------------------------
 // 
 // drawPanel
 //
+// Draws button on screen
+//
 //-----------------------------------------------------------------------------
-void Sketch::drawPanel( void )
+void Button::drawPanel( void )
 {
-	tft.drawRect(_x, _y, _w, _h, FG_COLOR1);
-	tft.fillRect(_x + 1, _y + 1, _w - 2, _h - 2, DARK_GRAY);
-	// don't be dumb and make it small or it will probably have issues
-	uint16_t x0 = _x + _w/2;
-	uint16_t y0 = _y + _h/2;
-	uint8_t xi = _w/8;
-	uint8_t yi = _h/8;
-	uint8_t x_ax = _w/16;
-	uint8_t y_ax = _h/16;
+	// don't need edges of button to be filled
+	_display->fillRect(_x+1, _y+1, _w-2, _h-2, _color);
+	// edges show the state
+	_display->drawRect(_x, _y, _w, _h, _state ? FG_COLOR3 : BG_COLOR);
+}
 
-	for( uint16_t i = 0; i < 8; i++ )
+//-----------------------------------------------------------------------------
+// 
+// handleEvent
+//
+// Toggles once per press, however long it's held
+//
+//-----------------------------------------------------------------------------
+void Button::handleEvent( uint8_t event, uint16_t x, uint16_t y )
+{
+	if( event == TOUCH_PRESS )
+	{
+		updatePanel(x, y);
+	}
+	else if( _repeat && ((event == TOUCH_LONG_PRESS) ||
+		(event == TOUCH_REPEAT)) )
 	{
-		tft.drawFastHLine( i*xi, y0, x_ax, FG_COLOR1 ); 
-		tft.drawFastVLine( x0, i*yi + _y, y_ax, FG_COLOR1 );
+		callMethod(x, y);
 	}
 }
 
@@ -292,49 +299,65 @@ void Sketch::drawPanel( void )
 // 
 // updatePanel
 //
+// Toggles the button
+//
 //-----------------------------------------------------------------------------
-void Sketch::updatePanel( uint16_t x, uint16_t y )
+void Button::updatePanel( uint16_t x, uint16_t y)
 {
 	// call bound method
-	(*_method)(x, y, this);
-	tft.fillCircle(x, y, PENRADIUS, _color);
+	callMethod(x, y);
+	// toggle button, only the edges change
+	_state = !_state;
+	markDirty(_x, _y, _w, 1);
+	markDirty(_x, _y + _h - 1, _w, 1);
+	markDirty(_x, _y + 1, 1, _h - 2);
+	markDirty(_x + _w - 1, _y + 1, 1, _h - 2);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// loadState
+//
+// A button left on is pressed once, the same way a touch would
+//
+//-----------------------------------------------------------------------------
+void Button::loadState( const uint8_t *buf )
+{
+	if( (buf[0] != 0) != _state )
+	{
+		callMethod(_x + _w/2, _y + _h/2);
+		_state = !_state;
+	}
 }
 
+
 //*****************************************************************************
 //
-// Knob class
+// Fader class
 //
 //*****************************************************************************
 
+// what a column of the fader looks like
+#define FADER_OUTSIDE 0 // track, or nothing past its ends
+#define FADER_EDGE 1 // all fader color
+#define FADER_INSIDE 2 // fader color at the top and bottom only
+
 //-----------------------------------------------------------------------------
 // 
 // Constructor
 //
 //-----------------------------------------------------------------------------
-Knob::Knob( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+Fader::Fader( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color ) :
 			Panel(x, y, w, h, method),
-			_color(color)
+			_color(color),
+			_value(0, 1)
 {
-	if( _w > _h ) // this needs to be a square
-	{
-		// put corner of circle in middle of range
-		_x += (_w - _h)/2;
-		_w = _h;
-		_r = _h/2;
-	}
-	else
-	{
-		// put corner of circle in middle of range
-		_y += (_h - _w)/2;
-		_h = _w;
-		_r = _w/2;
-	}
-	_r2 = _r * _r;
-
-	_old_xplot = 0;
-	_old_yplot = 0;
+	// starts all the way to the left
+	_pos = _x + _border;
+	// one step per pixel the center can move
+	_value.setRange(0, hi() - lo(), 1, 0);
 }
 
 //-----------------------------------------------------------------------------
@@ -342,11 +365,16 @@ Knob::Knob( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 // drawPanel
 //
 //-----------------------------------------------------------------------------
-void Knob::drawPanel( void )
+void Fader::drawPanel( void )
 {
-	tft.drawRoundRect( _x, _y, 2*_r, 2*_r, _r, FG_COLOR1 );
-	// put value in center of circle
-	tft.fillCircle( _x + _w - 2 * _border , _y + _r, _border, _color );
+	// draw fader track
+	_display->drawFastHLine(lo(), _y + _h/3, hi() - lo(), FG_COLOR1);
+	_display->drawFastHLine(lo(), _y + 2*_h/3, hi() - lo(), FG_COLOR1);
+	// draw fader
+	_display->drawRect(_pos, _y + _border, _x_dim, yDim(), _color);
+	// "erase" track where fader is	
+	_display->drawFastHLine(_pos + 1, _y + _h/3, _x_dim - 2 , BG_COLOR);
+	_display->drawFastHLine(_pos + 1, _y + 2*_h/3, _x_dim - 2, BG_COLOR);
 }
 
 //-----------------------------------------------------------------------------
@@ -354,190 +382,1898 @@ void Knob::drawPanel( void )
 // updatePanel
 //
 //-----------------------------------------------------------------------------
-void Knob::updatePanel( uint16_t x, uint16_t y )
+void Fader::updatePanel( uint16_t x, uint16_t y )
 {
-	// diameter of circle to be displayed
-	static uint8_t d_border = 2*_r - 3*_border;
-	//uint8_t _r_border2 = _r_border * _r_border;
-	uint8_t index;
-	uint8_t cost; // cosine and sine values
-	uint8_t sint;
-	uint16_t xplot;
-	uint16_t yplot;
-	(*_method)(x, y, this);
-	
-	if ( x - _x < _r/2 )
-	{
-		x = _r/2 + _x;
-	}
-	index = getTheta(x, y, this, true);
-	sint = pgm_read_byte_near( sin21 + index );
-	cost = pgm_read_byte_near( cos21 + index );
-	// kind of like mapping from -r to r
-	xplot = map(sint, 0, 128, 0, d_border);
-	// although could probably save space here and just map
-	// from 0 to r
-	// although maybe some kind of sin function will be needed again 
-	yplot = map(cost, 0, 128, 0, d_border);
-	if(_old_xplot) // erase previous mark
-	{
-		tft.fillCircle( _old_xplot, _old_yplot, _border, BG_COLOR );
-	}
-	else // first touch
-	{
-		tft.fillCircle( _x + _w - 2 * _border , _y + _r, _border, BG_COLOR );
-	}
-	// add offset due to position of knob 
-	xplot += (_x+_border);
-
-	if ( y - _r > _y ) // "positive" horizontal
-	{
-		yplot += (_y - _border);
-	}
-	else // "negative" horizontal
+	// want to make sure everything stays on screen
+	uint8_t center = x < lo() ? lo() : (x > hi() ? hi() : x);
+	if( !_value.track(center - lo(), hi() - lo()) )
 	{
-		yplot = _y + _w + _border - yplot;
+		return;
 	}
-	_old_xplot = xplot;
-	_old_yplot = yplot;
-	tft.fillCircle( xplot, yplot, _border, _color );//_border
+	// call bound method
+	callMethod(x, y, true);
+	markPending();
 }
 
-
-//*****************************************************************************
-//
-// Menu class
-//
-//*****************************************************************************
-
 //-----------------------------------------------------------------------------
 // 
-// Constructor
+// render
+//
+// Moves the fader to where the value is
 //
 //-----------------------------------------------------------------------------
-Menu::Menu( void )
+void Fader::render( void )
 {
-	_head = NULL;
-	_tail = NULL;
+	moveTo(lo() + _value.position(hi() - lo()) - _x_dim/2);
 }
 
 //-----------------------------------------------------------------------------
 // 
-// Destructor
+// setRange
+//
+// The fader moves to where its value ends up in the new range, the
+// method isn't called
 //
 //-----------------------------------------------------------------------------
-Menu::~Menu( void )
+void Fader::setRange( int16_t lo, int16_t hi, uint16_t step,
+			uint16_t hysteresis )
 {
-	Panel *ppanel;
-	do 
-	{
-		ppanel  = _head;
-		_head = ppanel->getNext();
-		delete ppanel;
-	} while( ppanel != NULL );
+	_value.setRange(lo, hi, step, hysteresis);
+	markPending();
 }
 
 //-----------------------------------------------------------------------------
 // 
-// addPanel
+// setValue
 //
-// Adds a panel to the menu
+// Moves the fader from code, the method isn't called. In a Menu it's
+// drawn when the menu next flushes, whichever page is showing.
 //
 //-----------------------------------------------------------------------------
-void Menu::addPanel( Panel *ppanel)
+void Fader::setValue( int16_t value )
 {
-	// if first node
-	if( _head == NULL )
-	{
-		_head = ppanel;
-		_tail = ppanel;
-	}
-	else
+	if( _value.set(value) )
 	{
-		_tail->setNext(ppanel);
-		_tail = ppanel;
+		markPending();
 	}
 }
+
 //-----------------------------------------------------------------------------
 // 
-// drawMenu
+// saveState, loadState
 //
-// calls drawPanel() function of all panels
+// The value, low byte first. The method is called with the center the
+// value puts the fader at, like a touch there.
 //
 //-----------------------------------------------------------------------------
-void Menu::drawMenu( void )
+void Fader::saveState( uint8_t *buf )
 {
-	Panel *ppanel = _head;
-	while( ppanel != NULL )
+	int16_t value = _value.get();
+	buf[0] = value;
+	buf[1] = value >> 8;
+}
+
+void Fader::loadState( const uint8_t *buf )
+{
+	if( !_value.set((int16_t)(buf[0] | (buf[1] << 8))) )
 	{
-		ppanel->drawPanel();
-		ppanel = ppanel->getNext();
+		return;
 	}
+	uint8_t center = lo() + _value.position(hi() - lo());
+	_pos = center - _x_dim/2;
+	callMethod(center, _y + _h/2);
 }
 
 //-----------------------------------------------------------------------------
 // 
-// isTouched
+// moveTo
 //
-// calls isTouched() functions of all panels
+// Moves the left edge of the fader to pos
 //
 //-----------------------------------------------------------------------------
-void Menu::isTouched( uint16_t x, uint16_t y )
+void Fader::moveTo( uint8_t pos )
 {
-	Panel *ppanel = _head;
-	while( ppanel != NULL )
+	if( pos == _pos )
+	{
+		return;
+	}
+
+	// only the columns swept by the left and right edges change, walked
+	// left to right so the batch can join neighbouring pixels into lines
+	uint16_t right = _x_dim - 1;
+	uint16_t lo = pos < _pos ? pos : _pos;
+	uint16_t hi = pos < _pos ? _pos : pos;
+	// the columns only know the track, not what other panels put there
+	Rect r = { (int16_t)lo, (int16_t)_y, (int16_t)(hi + right - lo + 1),
+		(int16_t)_h };
+	if( overlapped(r) )
 	{
-		// return as soon as first panel is touched
-		// panels shouldn't overlap anyways
-		if( ppanel->isTouched(x, y) )
+		_pos = pos;
+		repaint(r);
+		return;
+	}
+	_display->beginBatch();
+	if( hi - lo >= right )
+	{
+		// moved further than its width, the two edges sweep one range
+		for( uint16_t col = lo; col <= hi + right; col++ )
 		{
-			return;
+			moveColumn(col, _pos, pos);
+		}
+	}
+	else
+	{
+		for( uint16_t col = lo; col <= hi; col++ )
+		{
+			moveColumn(col, _pos, pos);
+		}
+		for( uint16_t col = lo + right; col <= hi + right; col++ )
+		{
+			moveColumn(col, _pos, pos);
 		}
-		ppanel = ppanel->getNext();
 	}
+	_display->endBatch();
+	_pos = pos;
 }
 
-
 //-----------------------------------------------------------------------------
 // 
-// getTheta
+// columnAt
 //
-// necessary in order to use the Knob class
+// What column col looks like with the fader's left edge at pos
 //
 //-----------------------------------------------------------------------------
-uint8_t getTheta( uint16_t x, uint16_t y, Panel* ppanel, bool ind )
+uint8_t Fader::columnAt( uint8_t pos, uint16_t col )
 {
-	uint16_t _x = ppanel->getX();
-	uint16_t _y = ppanel->getY();
-	uint8_t _r = ppanel->getMax();
-	// x and y relative to knob edges
-	uint16_t x_knob = x - _x;
-	uint16_t y_knob = y - _y;
-	uint8_t x_index;
-	uint8_t y_index;
-	uint8_t theta;
-
-	if( ind ) // return index instead of theta
+	if( (col == pos) || (col == pos + _x_dim - 1) )
 	{
-		x_index = map(x_knob, 0, 2*_r, 0, TRIG_LEN); 
-		return x_index;
-	}
-	if(x_knob < _r){
-		x_index = map(x_knob, 0, 2*_r, 0, TRIG_LEN);
-		if( ind ){
-			return x_index;
-		} 
-		theta = pgm_read_byte_near(asin21 + x_index);
-		if( y_knob < _r ){ // need to reflect angle across horizontal axis
-			theta = 255 - theta;
-		}
+		return FADER_EDGE;
 	}
-	else{
-		y_index = map(y_knob, 0, 2*_r, 0, TRIG_LEN);
-		if( ind ){
-			return y_index;
-		}
-		theta = pgm_read_byte_near(acos21 + y_index);
+	if( (col > pos) && (col < pos + _x_dim - 1) )
+	{
+		return FADER_INSIDE;
 	}
-	return theta;
+	return FADER_OUTSIDE;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// moveColumn
+//
+// Redraws the pixels of a column that differ between the fader at from
+// and at to, it's only ever a run down the column and the track pixels
+//
+//-----------------------------------------------------------------------------
+void Fader::moveColumn( uint16_t col, uint8_t from, uint8_t to )
+{
+	uint8_t was = columnAt(from, col);
+	uint8_t is = columnAt(to, col);
+	if( was == is )
+	{
+		return;
+	}
+	uint16_t top = _y + _border;
+	uint16_t bottom = top + yDim() - 1;
+	bool track = (col >= lo()) && (col < hi());
+	if( is == FADER_EDGE )
+	{
+		// inside already has the top and bottom
+		if( was == FADER_INSIDE )
+		{
+			_display->drawFastVLine(col, top + 1, yDim() - 2, _color);
+		}
+		else
+		{
+			_display->drawFastVLine(col, top, yDim(), _color);
+		}
+	}
+	else if( is == FADER_INSIDE )
+	{
+		if( was == FADER_EDGE )
+		{
+			_display->drawFastVLine(col, top + 1, yDim() - 2, BG_COLOR);
+		}
+		else
+		{
+			_display->drawPixel(col, top, _color);
+			_display->drawPixel(col, bottom, _color);
+			if( track )
+			{
+				_display->drawPixel(col, _y + _h/3, BG_COLOR);
+				_display->drawPixel(col, _y + 2*_h/3, BG_COLOR);
+			}
+		}
+	}
+	else
+	{
+		if( was == FADER_EDGE )
+		{
+			_display->drawFastVLine(col, top, yDim(), BG_COLOR);
+		}
+		else
+		{
+			_display->drawPixel(col, top, BG_COLOR);
+			_display->drawPixel(col, bottom, BG_COLOR);
+		}
+		if( track )
+		{
+			_display->drawPixel(col, _y + _h/3, FG_COLOR1);
+			_display->drawPixel(col, _y + 2*_h/3, FG_COLOR1);
+		}
+	}
+}
+
+
+//*****************************************************************************
+//
+// Sketch class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+// 
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Sketch::Sketch( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
+			uint16_t color ) :
+			Panel(x, y, w, h, method),
+			_color(color)
+{
+	_state = false;
+	_count = 0;
+	_ink_x = 0;
+	_ink_y = 0;
+	_version = 0;
+	clearTable();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// clearTable
+//
+// Flattens the wavetable to the middle, what's on screen is left alone
+//
+//-----------------------------------------------------------------------------
+void Sketch::clearTable( void )
+{
+	for( uint16_t i = 0; i < SKETCH_TABLE_LEN; i++ )
+	{
+		_table[i] = 128;
+	}
+	_version++;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// drawPanel
+//
+//-----------------------------------------------------------------------------
+void Sketch::drawPanel( void )
+{
+	_display->drawRect(_x, _y, _w, _h, FG_COLOR1);
+	_display->fillRect(_x + 1, _y + 1, _w - 2, _h - 2, DARK_GRAY);
+	// don't be dumb and make it small or it will probably have issues
+	uint16_t x0 = _x + _w/2;
+	uint16_t y0 = _y + _h/2;
+	uint8_t xi = _w/8;
+	uint8_t yi = _h/8;
+	uint8_t x_ax = _w/16;
+	uint8_t y_ax = _h/16;
+
+	for( uint16_t i = 0; i < 8; i++ )
+	{
+		_display->drawFastHLine( i*xi, y0, x_ax, FG_COLOR1 ); 
+		_display->drawFastVLine( x0, i*yi + _y, y_ax, FG_COLOR1 );
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// updatePanel
+//
+// The wavetable takes the stroke now, the screen at the next flush
+//
+//-----------------------------------------------------------------------------
+void Sketch::updatePanel( uint16_t x, uint16_t y )
+{
+	// call bound method
+	callMethod(x, y);
+	// join up with the last sample so fast strokes don't turn into dots
+	if( _state )
+	{
+		capture(_pen_x, _pen_y, x, y);
+	}
+	else
+	{
+		capture(x, y, x, y);
+	}
+	// full, the last point moves here and the line to it gets longer
+	// a pen down in between still breaks the stroke
+	bool start = !_state;
+	if( _count == SKETCH_PENDING )
+	{
+		_count--;
+		start |= _points[_count].start;
+	}
+	_points[_count].x = x;
+	_points[_count].y = y;
+	_points[_count].start = start;
+	_count++;
+	_state = true;
+	_pen_x = x;
+	_pen_y = y;
+	markPending();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// handleEvent
+//
+// Every touch starts a new stroke
+//
+//-----------------------------------------------------------------------------
+void Sketch::handleEvent( uint8_t event, uint16_t x, uint16_t y )
+{
+	if( event == TOUCH_PRESS )
+	{
+		_state = false;
+	}
+	else if( event == TOUCH_RELEASE )
+	{
+		_state = false;
+		return;
+	}
+	Panel::handleEvent(event, x, y);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// render
+//
+// Draws the strokes since the last flush
+//
+//-----------------------------------------------------------------------------
+void Sketch::render( void )
+{
+	for( uint8_t i = 0; i < _count; i++ )
+	{
+		if( _points[i].start )
+		{
+			stroke(_points[i].x, _points[i].y, _points[i].x, _points[i].y);
+		}
+		else
+		{
+			stroke(_ink_x, _ink_y, _points[i].x, _points[i].y);
+		}
+		_ink_x = _points[i].x;
+		_ink_y = _points[i].y;
+	}
+	_count = 0;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// toIndex, toSample
+//
+// Table index of a column and sample value of a row, the inside of the
+// border spans the whole table and all the sample values
+//
+//-----------------------------------------------------------------------------
+int16_t Sketch::toIndex( int16_t x )
+{
+	int32_t i = (int32_t)(x - _x - 1) * (SKETCH_TABLE_LEN - 1) / (_w - 3);
+	return i < 0 ? 0 : (i >= SKETCH_TABLE_LEN ? SKETCH_TABLE_LEN - 1 : i);
+}
+
+uint8_t Sketch::toSample( int16_t y )
+{
+	int32_t v = (int32_t)(_y + _h - 2 - y) * 255 / (_h - 3);
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// capture
+//
+// Writes a segment of stroke into the wavetable, a straight line between
+// the samples at its two ends
+//
+//-----------------------------------------------------------------------------
+void Sketch::capture( int16_t x0, int16_t y0, int16_t x1, int16_t y1 )
+{
+	int16_t i0 = toIndex(x0);
+	int16_t i1 = toIndex(x1);
+	int16_t v0 = toSample(y0);
+	int16_t v1 = toSample(y1);
+	if( i1 < i0 )
+	{
+		int16_t t = i0; i0 = i1; i1 = t;
+		t = v0; v0 = v1; v1 = t;
+	}
+	int16_t di = i1 - i0;
+	if( di == 0 )
+	{
+		_table[i0] = v1;
+	}
+	else
+	{
+		// rounded, so the ends land exactly on v0 and v1
+		int32_t dv = v1 - v0;
+		for( int16_t i = 0; i <= di; i++ )
+		{
+			_table[i0 + i] = v0 + (dv * 2 * i + (dv < 0 ? -di : di)) / (2 * di);
+		}
+	}
+	_version++;
+}
+
+//-----------------------------------------------------------------------------
+//
+// floorDiv, isqrt, limit
+//
+// integer helpers for Sketch::stroke()
+//
+//-----------------------------------------------------------------------------
+static int32_t floorDiv( int32_t n, int32_t d )
+{
+	// d is always positive here
+	int32_t q = n / d;
+	if( (n % d != 0) && (n < 0) )
+	{
+		q--;
+	}
+	return q;
+}
+
+static uint16_t isqrt( uint32_t n )
+{
+	uint32_t root = 0;
+	uint32_t bit = (uint32_t)1 << 30;
+	while( bit > n )
+	{
+		bit >>= 2;
+	}
+	while( bit != 0 )
+	{
+		if( n >= root + bit )
+		{
+			n -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+// narrows [*pmin, *pmax] to the x for which lo <= k * x + b <= hi
+static void limit( int32_t k, int32_t b, int32_t lo, int32_t hi,
+	int32_t *pmin, int32_t *pmax )
+{
+	if( k == 0 )
+	{
+		if( (b < lo) || (b > hi) )
+		{
+			*pmin = 1;
+			*pmax = 0;
+		}
+		return;
+	}
+	if( k < 0 )
+	{
+		int32_t t = lo;
+		lo = -hi;
+		hi = -t;
+		k = -k;
+		b = -b;
+	}
+	int32_t a = -floorDiv(b - lo, k);
+	int32_t c = floorDiv(hi - b, k);
+	if( a > *pmin ) *pmin = a;
+	if( c < *pmax ) *pmax = c;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// stroke
+//
+// Draws a line PENRADIUS thick with round ends from x0, y0 to x1, y1, as
+// one horizontal span per row, all sent as one batch
+// Each row is the widest of the two end caps and the band along the line:
+// the points no further than PENRADIUS from the line, that lie between
+// the ends
+//
+//-----------------------------------------------------------------------------
+void Sketch::stroke( int16_t x0, int16_t y0, int16_t x1, int16_t y1 )
+{
+	const int16_t r = PENRADIUS;
+	// rows are walked top to bottom
+	if( y1 < y0 )
+	{
+		int16_t t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	int32_t dx = x1 - x0;
+	int32_t dy = y1 - y0;
+	int32_t len2 = dx * dx + dy * dy;
+	int32_t band = (int32_t)r * isqrt(len2);
+	// pen stays inside the border
+	Rect clip = _display->getClip();
+	_display->beginBatch();
+	_display->setClip(_x + 1, _y + 1, _w - 2, _h - 2);
+	for( int16_t y = y0 - r; y <= y1 + r; y++ )
+	{
+		int32_t lo = 0x7FFF;
+		int32_t hi = -0x7FFF;
+		// end caps
+		int16_t d0 = y - y0;
+		int16_t d1 = y - y1;
+		if( (d0 >= -r) && (d0 <= r) )
+		{
+			int16_t half = isqrt(r * r + r - d0 * d0);
+			lo = x0 - half;
+			hi = x0 + half;
+		}
+		if( (d1 >= -r) && (d1 <= r) )
+		{
+			int16_t half = isqrt(r * r + r - d1 * d1);
+			if( x1 - half < lo ) lo = x1 - half;
+			if( x1 + half > hi ) hi = x1 + half;
+		}
+		// band, x relative to x0
+		if( len2 != 0 )
+		{
+			int32_t bmin = -0x7FFF;
+			int32_t bmax = 0x7FFF;
+			limit(dy, -(int32_t)d0 * dx, -band, band, &bmin, &bmax);
+			limit(dx, (int32_t)d0 * dy, 0, len2, &bmin, &bmax);
+			if( bmin <= bmax )
+			{
+				if( x0 + bmin < lo ) lo = x0 + bmin;
+				if( x0 + bmax > hi ) hi = x0 + bmax;
+			}
+		}
+		if( lo <= hi )
+		{
+			_display->drawFastHLine(lo, y, hi - lo + 1, _color);
+		}
+	}
+	_display->setClip(clip.x, clip.y, clip.w, clip.h);
+	_display->endBatch();
+}
+
+//*****************************************************************************
+//
+// Knob class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+// 
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Knob::Knob( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
+			uint16_t color ) :
+			Panel(x, y, w, h, method),
+			_color(color),
+			_value(0, 255)
+{
+	if( _w > _h ) // this needs to be a square
+	{
+		// put corner of circle in middle of range
+		_x += (_w - _h)/2;
+		_w = _h;
+		_r = _h/2;
+	}
+	else
+	{
+		// put corner of circle in middle of range
+		_y += (_h - _w)/2;
+		_h = _w;
+		_r = _w/2;
+	}
+
+	// mark starts on the right, in the middle
+	_value.set(128);
+	markAt(&_xplot, &_yplot);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// drawPanel
+//
+//-----------------------------------------------------------------------------
+void Knob::drawPanel( void )
+{
+	_display->drawRoundRect( _x, _y, 2*_r, 2*_r, _r, FG_COLOR1 );
+	// put value in center of circle
+	_display->fillCircle( _xplot, _yplot, _border, _color );
+}
+
+//-----------------------------------------------------------------------------
+// 
+// updatePanel
+//
+//-----------------------------------------------------------------------------
+void Knob::updatePanel( uint16_t x, uint16_t y )
+{
+	// angle from the left, counterclockwise on screen
+	uint16_t angle = ANGLE_HALF - angleAtan2((int16_t)y - (_y + _r),
+		(int16_t)x - (_x + _r));
+	if( !_value.track(angle >> KNOB_ANGLE_SHIFT, KNOB_TURN) )
+	{
+		return;
+	}
+	callMethod(x, y, true);
+	markPending();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// setRange
+//
+// The mark moves to where the value ends up in the new range, the method
+// isn't called
+//
+//-----------------------------------------------------------------------------
+void Knob::setRange( int16_t lo, int16_t hi, uint16_t step,
+			uint16_t hysteresis )
+{
+	_value.setRange(lo, hi, step, hysteresis);
+	markPending();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// setValue
+//
+// Turns the knob from code, the method isn't called. In a Menu it's
+// drawn when the menu next flushes, whichever page is showing.
+//
+//-----------------------------------------------------------------------------
+void Knob::setValue( int16_t value )
+{
+	if( _value.set(value) )
+	{
+		markPending();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// saveState, loadState
+//
+// The value, low byte first. The method is called with where the mark
+// ends up, like a touch there.
+//
+//-----------------------------------------------------------------------------
+void Knob::saveState( uint8_t *buf )
+{
+	int16_t value = _value.get();
+	buf[0] = value;
+	buf[1] = value >> 8;
+}
+
+void Knob::loadState( const uint8_t *buf )
+{
+	if( !_value.set((int16_t)(buf[0] | (buf[1] << 8))) )
+	{
+		return;
+	}
+	markAt(&_xplot, &_yplot);
+	callMethod(_xplot, _yplot);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// markAt
+//
+// Center of the mark for the value, just inside the edge
+//
+//-----------------------------------------------------------------------------
+void Knob::markAt( uint16_t *pxplot, uint16_t *pyplot )
+{
+	int16_t cost; // cosine and sine values
+	int16_t sint;
+	uint8_t d = _r - 2 * _border;
+	uint16_t angle = (uint32_t)_value.position(KNOB_TURN) << KNOB_ANGLE_SHIFT;
+	angleSinCos(ANGLE_HALF - angle, &sint, &cost);
+	*pxplot = _x + _r + (((int32_t)cost * d + ANGLE_ONE/2) >> ANGLE_SHIFT);
+	*pyplot = _y + _r + (((int32_t)sint * d + ANGLE_ONE/2) >> ANGLE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// render
+//
+// Erases the mark and draws it where the value is now
+//
+//-----------------------------------------------------------------------------
+void Knob::render( void )
+{
+	uint16_t xplot;
+	uint16_t yplot;
+	markAt(&xplot, &yplot);
+	if( (xplot == _xplot) && (yplot == _yplot) )
+	{
+		return;
+	}
+	// one window over both spots when that's no bigger than two windows
+	uint8_t size = 2 * _border + 1;
+	int16_t left = (xplot < _xplot ? xplot : _xplot) - _border;
+	int16_t top = (yplot < _yplot ? yplot : _yplot) - _border;
+	uint8_t w = (xplot < _xplot ? _xplot - xplot : xplot - _xplot) + size;
+	uint8_t h = (yplot < _yplot ? _yplot - yplot : yplot - _yplot) + size;
+	uint16_t window = (DISPLAY_CASET_BYTES + DISPLAY_PASET_BYTES +
+		DISPLAY_RAMWR_BYTES) / 2;
+	int16_t old_x = _xplot;
+	int16_t old_y = _yplot;
+	_xplot = xplot;
+	_yplot = yplot;
+	// the sprite only knows the ring, not what other panels put there
+	Rect r = { left, top, w, h };
+	if( overlapped(r) )
+	{
+		Rect mark = { (int16_t)(old_x - _border), (int16_t)(old_y - _border),
+			size, size };
+		repaint(mark);
+		mark.x = _xplot - _border;
+		mark.y = _yplot - _border;
+		repaint(mark);
+		return;
+	}
+	if( (w <= KNOB_SPRITE_MAX) && (h <= KNOB_SPRITE_MAX) &&
+		((uint16_t)w * h <= 2 * size * size + window) )
+	{
+		blitMark(left, top, w, h);
+	}
+	else
+	{
+		blitMark(old_x - _border, old_y - _border, size, size);
+		blitMark(_xplot - _border, _yplot - _border, size, size);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// bakeRing
+//
+// Sets a bit in rows for each pixel of the ring that falls in the h rows
+// from y and the KNOB_SPRITE_MAX columns from x. Walks the corners the
+// same way drawRoundRect() does, there are no straight edges to add
+// since the corners meet.
+//
+//-----------------------------------------------------------------------------
+void Knob::bakeRing( int16_t x, int16_t y, uint8_t h, uint16_t *rows )
+{
+	// corner centers, drawRoundRect() with the width twice the radius
+	int16_t xl = _x + _r - x;
+	int16_t xr = _x + _r - 1 - x;
+	int16_t yt = _y + _r - y;
+	int16_t yb = _y + _r - 1 - y;
+	int16_t f = 1 - _r;
+	int16_t ddf_x = 1;
+	int16_t ddf_y = -2 * _r;
+	int16_t px = 0;
+	int16_t py = _r;
+	int16_t pts[16];
+
+	for( uint8_t i = 0; i < h; i++ )
+	{
+		rows[i] = 0;
+	}
+	while( px < py )
+	{
+		if( f >= 0 )
+		{
+			py--;
+			ddf_y += 2;
+			f += ddf_y;
+		}
+		px++;
+		ddf_x += 2;
+		f += ddf_x;
+		// column, row pairs relative to the window
+		pts[0] = xr + px; pts[1] = yb + py;
+		pts[2] = xr + py; pts[3] = yb + px;
+		pts[4] = xr + px; pts[5] = yt - py;
+		pts[6] = xr + py; pts[7] = yt - px;
+		pts[8] = xl - py; pts[9] = yb + px;
+		pts[10] = xl - px; pts[11] = yb + py;
+		pts[12] = xl - py; pts[13] = yt - px;
+		pts[14] = xl - px; pts[15] = yt - py;
+		for( uint8_t i = 0; i < 16; i += 2 )
+		{
+			if( ((uint16_t)pts[i] < KNOB_SPRITE_MAX) && ((uint16_t)pts[i + 1] < h) )
+			{
+				rows[pts[i + 1]] |= 1 << pts[i];
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// blitMark
+//
+// Sends the w x h window at x, y as it looks with the mark at _xplot,
+// _yplot: the mark over the ring over the background, in runs of color
+//
+//-----------------------------------------------------------------------------
+void Knob::blitMark( int16_t x, int16_t y, uint8_t w, uint8_t h )
+{
+	// fillCircle() with a radius of 2, the knob's border
+	static const PROGMEM uint8_t mark[] = { 0x0e, 0x1f, 0x1f, 0x1f, 0x0e };
+	uint16_t rows[KNOB_SPRITE_MAX];
+	int16_t mx = _xplot - _border - x;
+	int16_t my = _yplot - _border - y;
+	uint16_t color = BG_COLOR;
+	uint16_t len = 0;
+
+	bakeRing(x, y, h, rows);
+	_display->beginBlit(x, y, w, h);
+	for( uint8_t row = 0; row < h; row++ )
+	{
+		uint8_t bits = 0;
+		if( (uint8_t)(row - my) < sizeof(mark) )
+		{
+			bits = pgm_read_byte_near(&mark[row - my]);
+		}
+		for( uint8_t col = 0; col < w; col++ )
+		{
+			uint16_t c = BG_COLOR;
+			if( ((uint8_t)(col - mx) < 8) && (bits & (1 << (col - mx))) )
+			{
+				c = _color;
+			}
+			else if( rows[row] & (1 << col) )
+			{
+				c = FG_COLOR1;
+			}
+			if( (c != color) && len )
+			{
+				_display->blit(color, len);
+				len = 0;
+			}
+			color = c;
+			len++;
+		}
+	}
+	_display->blit(color, len);
+	_display->endBlit();
+}
+
+
+//*****************************************************************************
+//
+// Graph class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+// Rows are kept in a byte, so the inside of the border is at most 256 high
+//
+//-----------------------------------------------------------------------------
+Graph::Graph( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
+			uint16_t color ) :
+			Panel(x, y, w, h, method),
+			_color(color)
+{
+	if( _h > 258 )
+	{
+		_h = 258;
+	}
+	// the fewest pixels per column that fit the width in GRAPH_MAX_COLS
+	_col_w = (_w - 2 + GRAPH_MAX_COLS - 1) / GRAPH_MAX_COLS;
+	_cols = (_col_w > 0) ? (_w - 2) / _col_w : 0;
+	_lo = 0;
+	_hi = 255;
+	_decimation = 1;
+	_count = 0;
+	_min = INT16_MAX;
+	_max = INT16_MIN;
+	_head = 0;
+	_tail = 0;
+	_col = 0;
+	for( uint8_t c = 0; c < _cols; c++ )
+	{
+		_top[c] = 1;
+		_bottom[c] = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawPanel
+//
+// Shows the columns drawn so far, the queued ones are left to render()
+//
+//-----------------------------------------------------------------------------
+void Graph::drawPanel( void )
+{
+	_display->drawRect(_x, _y, _w, _h, FG_COLOR1);
+	_display->fillRect(_x + 1, _y + 1, _w - 2, _h - 2, DARK_GRAY);
+	for( uint8_t c = 0; c < _cols; c++ )
+	{
+		if( _top[c] <= _bottom[c] )
+		{
+			drawRows(c, _top[c], _bottom[c], _color);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// updatePanel
+//
+//-----------------------------------------------------------------------------
+void Graph::updatePanel( uint16_t x, uint16_t y )
+{
+	callMethod(x, y);
+}
+
+//-----------------------------------------------------------------------------
+//
+// push
+//
+// Producer side, only compares the sample until a column is complete
+//
+//-----------------------------------------------------------------------------
+void Graph::push( int16_t sample )
+{
+	if( sample < _min )
+	{
+		_min = sample;
+	}
+	if( sample > _max )
+	{
+		_max = sample;
+	}
+	if( ++_count < _decimation )
+	{
+		return;
+	}
+	uint8_t head = _head;
+	uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+	if( (uint8_t)(head - tail) == GRAPH_BACKLOG )
+	{
+		// no room, the column carries on collecting until there is
+		_count--;
+		return;
+	}
+	uint8_t i = head & (GRAPH_BACKLOG - 1);
+	_queue_top[i] = toRow(_max);
+	_queue_bottom[i] = toRow(_min);
+	__atomic_store_n(&_head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+	_count = 0;
+	_min = INT16_MAX;
+	_max = INT16_MIN;
+	deferRender();
+}
+
+void Graph::push( const int16_t *samples, uint16_t n )
+{
+	for( uint16_t i = 0; i < n; i++ )
+	{
+		push(samples[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// clear
+//
+// Empties the plot and starts again from the left, the column being
+// collected carries on
+//
+//-----------------------------------------------------------------------------
+void Graph::clear( void )
+{
+	for( uint8_t c = 0; c < _cols; c++ )
+	{
+		_top[c] = 1;
+		_bottom[c] = 0;
+	}
+	_col = 0;
+	__atomic_store_n(&_tail, __atomic_load_n(&_head, __ATOMIC_ACQUIRE),
+		__ATOMIC_RELEASE);
+	markDirty(_x, _y, _w, _h);
+}
+
+//-----------------------------------------------------------------------------
+//
+// toRow
+//
+// Row of a sample inside the border, lo on the bottom row
+//
+//-----------------------------------------------------------------------------
+uint8_t Graph::toRow( int16_t sample )
+{
+	if( sample < _lo )
+	{
+		sample = _lo;
+	}
+	if( sample > _hi )
+	{
+		sample = _hi;
+	}
+	int32_t rows = _h - 3;
+	return rows - ((int32_t)sample - _lo) * rows / ((int32_t)_hi - _lo);
+}
+
+//-----------------------------------------------------------------------------
+//
+// render
+//
+// Consumer side, draws every queued column
+//
+//-----------------------------------------------------------------------------
+void Graph::render( void )
+{
+	uint8_t tail = _tail;
+	uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+	while( tail != head )
+	{
+		uint8_t i = tail & (GRAPH_BACKLOG - 1);
+		drawColumn(_col, _queue_top[i], _queue_bottom[i]);
+		_col = (_col + 1 < _cols) ? _col + 1 : 0;
+		tail++;
+	}
+	__atomic_store_n(&_tail, tail, __ATOMIC_RELEASE);
+}
+
+//-----------------------------------------------------------------------------
+//
+// drawColumn
+//
+// Replaces what column c shows with top to bottom, only erasing the rows
+// the old envelope covered and the new one doesn't, and only drawing the
+// rows the new one adds
+//
+//-----------------------------------------------------------------------------
+void Graph::drawColumn( uint8_t c, uint8_t top, uint8_t bottom )
+{
+	int16_t old_top = _top[c];
+	int16_t old_bottom = _bottom[c];
+	_top[c] = top;
+	_bottom[c] = bottom;
+	if( old_top > old_bottom )
+	{
+		drawRows(c, top, bottom, _color);
+		return;
+	}
+	// above and below the new envelope
+	drawRows(c, old_top, (old_bottom < top) ? old_bottom : top - 1,
+		DARK_GRAY);
+	drawRows(c, (old_top > bottom) ? old_top : bottom + 1, old_bottom,
+		DARK_GRAY);
+	// above and below the old one
+	drawRows(c, top, (bottom < old_top) ? bottom : old_top - 1, _color);
+	drawRows(c, (top > old_bottom) ? top : old_bottom + 1, bottom, _color);
+}
+
+void Graph::drawRows( uint8_t c, int16_t top, int16_t bottom,
+	uint16_t color )
+{
+	if( top <= bottom )
+	{
+		_display->fillRect(_x + 1 + c * _col_w, _y + 1 + top, _col_w,
+			bottom - top + 1, color);
+	}
+}
+
+
+//*****************************************************************************
+//
+// Menu class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+// 
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Menu::Menu( void )
+{
+	enlist();
+	_arena = NULL;
+	_arena_size = 0;
+	_version = 0;
+	_budget_us = 0;
+	reset();
+#ifdef ARDUINO
+	_touch = &ctpTouch;
+#else
+	_touch = NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// 
+// Constructor
+//
+// Panels made with create() are built in arena, which must outlive the menu
+//
+//-----------------------------------------------------------------------------
+Menu::Menu( uint8_t *arena, uint16_t size )
+{
+	enlist();
+	_arena = arena;
+	_arena_size = size;
+	_version = 0;
+	_budget_us = 0;
+	reset();
+#ifdef ARDUINO
+	_touch = &ctpTouch;
+#else
+	_touch = NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// 
+// Destructor
+//
+//-----------------------------------------------------------------------------
+Menu::~Menu( void )
+{
+	Panel *ppanel = _head;
+	while( ppanel != NULL )
+	{
+		Panel *pnext = ppanel->getNext();
+		if( Panel::_queue != NULL )
+		{
+			Panel::_queue->remove(ppanel);
+		}
+		if( !inArena(ppanel) )
+		{
+			delete ppanel;
+		}
+		ppanel = pnext;
+	}
+	_menus[_index] = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// enlist
+//
+// Takes a free place in the table of menus, 0 when it's full
+//
+//-----------------------------------------------------------------------------
+void Menu::enlist( void )
+{
+	_index = 0;
+	for( uint8_t i = 1; (i <= MENU_MAX_MENUS) && (_index == 0); i++ )
+	{
+		if( _menus[i] == NULL )
+		{
+			_menus[i] = this;
+			_index = i;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// reset
+//
+// Empties the menu without freeing anything
+//
+//-----------------------------------------------------------------------------
+void Menu::reset( void )
+{
+	_head = NULL;
+	_tail = NULL;
+	_arena_used = 0;
+	_heap = 0;
+	_count = 0;
+	_overflow = NULL;
+	for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+	{
+		_owner[f] = NULL;
+		_gesture[f].up();
+	}
+	_version++;
+	for( uint8_t row = 0; row < MENU_GRID_ROWS; row++ )
+	{
+		for( uint8_t col = 0; col < MENU_GRID_COLS; col++ )
+		{
+			_grid[row][col] = 0;
+		}
+	}
+	_damage.clear();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// clear
+//
+// Removes every panel so the page can be rebuilt
+// The arena is released in one go, without running the destructors of the
+// panels in it, so unlike delete they don't erase themselves from the
+// screen. Only panels added with addPanel() have to be deleted one by one.
+//
+//-----------------------------------------------------------------------------
+void Menu::clear( void )
+{
+	Panel *ppanel = _head;
+	// methods still waiting would be called on panels that are gone
+	if( Panel::_queue != NULL )
+	{
+		for( ; ppanel != NULL; ppanel = ppanel->getNext() )
+		{
+			Panel::_queue->remove(ppanel);
+		}
+		ppanel = _head;
+	}
+	while( (_heap > 0) && (ppanel != NULL) )
+	{
+		Panel *pnext = ppanel->getNext();
+		if( !inArena(ppanel) )
+		{
+			delete ppanel;
+			_heap--;
+		}
+		ppanel = pnext;
+	}
+	reset();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// addPanel
+//
+// Adds a panel to the menu, which now owns it and will delete it
+//
+//-----------------------------------------------------------------------------
+void Menu::addPanel( Panel *ppanel)
+{
+	_heap++;
+	link(ppanel);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// link
+//
+// Adds a panel to the list and to the touch grid
+//
+//-----------------------------------------------------------------------------
+void Menu::link( Panel *ppanel )
+{
+	_version++;
+	ppanel->setNext(NULL);
+	ppanel->_menu = _index;
+	if( _count < MENU_MAX_PANELS )
+	{
+		// cells the panel overlaps, clamped to the screen's width, rows
+		// past the bottom wrap round
+		uint16_t x1 = ppanel->getX() + ppanel->getW() - 1;
+		uint16_t y1 = ppanel->getY() + ppanel->getH() - 1;
+		uint8_t col0 = ppanel->getX() >> MENU_GRID_SHIFT;
+		uint16_t row0 = ppanel->getY() >> MENU_GRID_SHIFT;
+		uint8_t col1 = x1 >> MENU_GRID_SHIFT;
+		uint16_t row1 = y1 >> MENU_GRID_SHIFT;
+		if( col1 >= MENU_GRID_COLS ) col1 = MENU_GRID_COLS - 1;
+		if( row1 - row0 >= MENU_GRID_ROWS ) row1 = row0 + MENU_GRID_ROWS - 1;
+		for( uint16_t row = row0; row <= row1; row++ )
+		{
+			for( uint8_t col = col0; col <= col1; col++ )
+			{
+				_grid[row % MENU_GRID_ROWS][col] |= (MenuCell)1 << _count;
+			}
+		}
+		_panels[_count++] = ppanel;
+	}
+	else if( _overflow == NULL )
+	{
+		_overflow = ppanel;
+	}
+
+	// if first node
+	if( _head == NULL )
+	{
+		_head = ppanel;
+		_tail = ppanel;
+	}
+	else
+	{
+		_tail->setNext(ppanel);
+		_tail = ppanel;
+	}
+}
+//-----------------------------------------------------------------------------
+// 
+// drawMenu
+//
+// calls drawPanel() function of all panels
+//
+//-----------------------------------------------------------------------------
+void Menu::drawMenu( void )
+{
+	Display *pdisplay = Panel::getDisplay();
+	pdisplay->beginBatch();
+	Panel *ppanel = _head;
+	while( ppanel != NULL )
+	{
+		ppanel->_unpainted = false;
+		ppanel->draw();
+		ppanel = ppanel->getNext();
+	}
+	// drawPanel() shows what was last rendered, catch up on the rest
+	for( ppanel = _head; ppanel != NULL; ppanel = ppanel->getNext() )
+	{
+		if( ppanel->_pending )
+		{
+			_version++;
+			ppanel->_pending = false;
+			ppanel->redraw();
+		}
+	}
+	pdisplay->endBatch();
+	// everything is up to date
+	_damage.clear();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// paintMenu
+//
+// Progressive drawMenu(): the panels are only marked, and each flush()
+// draws them within its budget, or one of them when there's no budget.
+// The page takes touches from the start, a panel being touched is drawn
+// before the rest, and the time to the first touch doesn't depend on how
+// much there is on the page. isFlushed() says when it's all drawn.
+//
+//-----------------------------------------------------------------------------
+void Menu::paintMenu( void )
+{
+	for( Panel *ppanel = _head; ppanel != NULL; ppanel = ppanel->getNext() )
+	{
+		ppanel->_unpainted = true;
+	}
+	// drawing the panels covers it
+	_damage.clear();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// isTouched
+//
+// handles one touch sample taken now and repaints what changed
+// Sketches that only call this while the screen is touched never say the
+// finger was lifted, so a touch also ends when the sample lands off its
+// panel or comes more than the release time after the last one, and the
+// next one is a new press. Long press and repeat are sent from here too.
+//
+//-----------------------------------------------------------------------------
+void Menu::isTouched( uint16_t x, uint16_t y )
+{
+	TouchPoint p = { x, (uint16_t)Panel::getDisplay()->toContent(y),
+		(uint32_t)millis(), 0, 1 };
+	for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+	{
+		if( (_owner[f] != NULL) && !_owner[f]->contains(p.x, p.y) )
+		{
+			release(f);
+		}
+	}
+	touch(&p, 1, true);
+	hold(p.t);
+	flush();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// isReleased
+//
+// The screen was polled and isn't touched, ends every touch
+//
+//-----------------------------------------------------------------------------
+void Menu::isReleased( void )
+{
+	for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+	{
+		if( _owner[f] != NULL )
+		{
+			release(f);
+		}
+	}
+	flush();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// find
+//
+// Returns the panel under a touch, or NULL
+// Only the panels in the grid cell under the touch are checked
+//
+//-----------------------------------------------------------------------------
+Panel* Menu::find( uint16_t x, uint16_t y )
+{
+	uint8_t col = x >> MENU_GRID_SHIFT;
+	uint8_t row = (y >> MENU_GRID_SHIFT) % MENU_GRID_ROWS;
+	if( col >= MENU_GRID_COLS )
+	{
+		return NULL;
+	}
+	// lowest bit first, so panels are still checked in the order added
+	MenuCell cell = _grid[row][col];
+	for( uint8_t i = 0; cell != 0; i++, cell >>= 1 )
+	{
+		// first panel touched wins, panels shouldn't overlap anyways
+		if( (cell & 1) && _panels[i]->contains(x, y) )
+		{
+			return _panels[i];
+		}
+	}
+	Panel *ppanel = _overflow;
+	while( ppanel != NULL )
+	{
+		if( ppanel->contains(x, y) )
+		{
+			return ppanel;
+		}
+		ppanel = ppanel->getNext();
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// deliver
+//
+// Passes an event to the panel that owns the finger's touch, anything it
+// changes is added to the damage list instead of being drawn
+//
+//-----------------------------------------------------------------------------
+void Menu::deliver( uint8_t finger, uint8_t event, uint16_t x, uint16_t y )
+{
+	_version++;
+	Panel::_event = event;
+	_owner[finger]->handle(event, x, y);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// touch
+//
+// Feeds the points of one poll to the gesture state machines
+// For a buffered source, whose samples carry the time they were taken, a
+// gap of more than the release time since a finger's last sample means
+// it was lifted in between, so it ends the old touch and starts a new one.
+// A direct poll says when the screen isn't touched, so a slow loop()
+// doesn't split a held touch into several.
+// A poll holds every finger that's down, so unless the read cut it short
+// a touch without a point in it has been lifted.
+//
+//-----------------------------------------------------------------------------
+void Menu::touch( const TouchPoint *points, uint8_t n, bool buffered )
+{
+	uint8_t finger[MENU_MAX_TOUCHES];
+	for( uint8_t f = 0; (f < MENU_MAX_TOUCHES) && buffered; f++ )
+	{
+		if( (_owner[f] != NULL) && _gesture[f].expired(points[0].t) )
+		{
+			release(f);
+		}
+	}
+	if( n > MENU_MAX_TOUCHES )
+	{
+		n = MENU_MAX_TOUCHES;
+	}
+	uint8_t matched = gestureMatch(_gesture, points, n, finger);
+	if( (points[0].id == 0) && (n >= points[0].count) )
+	{
+		for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+		{
+			if( (_owner[f] != NULL) && !(matched & (1 << f)) )
+			{
+				release(f);
+			}
+		}
+	}
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		uint8_t f = finger[i];
+		if( f == MENU_MAX_TOUCHES )
+		{
+			press(points[i]);
+		}
+		else if( _gesture[f].move(points[i]) )
+		{
+			deliver(f, TOUCH_MOVE, points[i].x, points[i].y);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// press
+//
+// Starts the touch of a new finger
+// A touch that starts on nothing is picked up by the first panel it slides
+// onto. A panel already held by the other finger ignores this one.
+//
+//-----------------------------------------------------------------------------
+void Menu::press( const TouchPoint &p )
+{
+	Panel *ppanel = find(p.x, p.y);
+	uint8_t free = MENU_MAX_TOUCHES;
+	for( uint8_t f = 0; (f < MENU_MAX_TOUCHES) && (ppanel != NULL); f++ )
+	{
+		if( _owner[f] == ppanel )
+		{
+			return;
+		}
+		if( (_owner[f] == NULL) && (free == MENU_MAX_TOUCHES) )
+		{
+			free = f;
+		}
+	}
+	if( (ppanel == NULL) || (free == MENU_MAX_TOUCHES) )
+	{
+		return;
+	}
+	_owner[free] = ppanel;
+	_gesture[free].press(p);
+	deliver(free, TOUCH_PRESS, p.x, p.y);
+}
+
+//-----------------------------------------------------------------------------
+// 
+// hold
+//
+// Times out the touches, and sends long press and repeat events while held
+//
+//-----------------------------------------------------------------------------
+void Menu::hold( uint32_t now )
+{
+	for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+	{
+		if( _owner[f] == NULL )
+		{
+			continue;
+		}
+		uint8_t event = _gesture[f].hold(now);
+		if( event == TOUCH_RELEASE )
+		{
+			release(f);
+		}
+		else if( event != TOUCH_NO_EVENT )
+		{
+			deliver(f, event, _gesture[f].getX(), _gesture[f].getY());
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+// release
+//
+//-----------------------------------------------------------------------------
+void Menu::release( uint8_t finger )
+{
+	deliver(finger, TOUCH_RELEASE, _gesture[finger].getX(),
+		_gesture[finger].getY());
+	_gesture[finger].up();
+	_owner[finger] = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// flush
+//
+// Renders the pending panels and repaints the damaged regions, those
+// under a finger first, until everything is drawn or the budget is spent
+// The whole flush is sent as one batch
+//
+//-----------------------------------------------------------------------------
+void Menu::flush( void )
+{
+	Display *pdisplay = Panel::getDisplay();
+	uint32_t start = micros();
+	bool drawn = false;
+	bool painted = false;
+	pdisplay->beginBatch();
+	if( flushSome(true, start, &drawn, &painted) )
+	{
+		flushSome(false, start, &drawn, &painted);
+	}
+	pdisplay->endBatch();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// flushSome
+//
+// The part of flush() for the panels and regions that are, or aren't,
+// under a finger. At least one thing is drawn per flush so a small budget
+// still gets through. Returns false once the budget is spent.
+// A panel left by paintMenu() is drawn whole instead of rendered, and
+// without a budget only one of them is drawn per flush, see ppainted.
+//
+//-----------------------------------------------------------------------------
+bool Menu::flushSome( bool owned, uint32_t start, bool *pdrawn,
+	bool *ppainted )
+{
+	for( Panel *ppanel = _head; ppanel != NULL; ppanel = ppanel->getNext() )
+	{
+		if( !(ppanel->_pending || ppanel->_unpainted) ||
+			(isOwned(ppanel) != owned) )
+		{
+			continue;
+		}
+		if( ppanel->_unpainted && (_budget_us == 0) && *ppainted )
+		{
+			continue;
+		}
+		if( *pdrawn && (_budget_us != 0) &&
+			((uint32_t)micros() - start >= _budget_us) )
+		{
+			return false;
+		}
+		if( ppanel->_unpainted )
+		{
+			ppanel->_unpainted = false;
+			ppanel->draw();
+			*ppainted = true;
+		}
+		if( ppanel->_pending )
+		{
+			// a Graph marks itself from an interrupt, count it here
+			_version++;
+			ppanel->_pending = false;
+			ppanel->redraw();
+		}
+		*pdrawn = true;
+	}
+	uint8_t i = 0;
+	while( i < _damage.getCount() )
+	{
+		Rect r = _damage.getRect(i);
+		bool under = false;
+		for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+		{
+			under |= (_owner[f] != NULL) && _owner[f]->intersects(r);
+		}
+		if( under != owned )
+		{
+			i++;
+			continue;
+		}
+		if( *pdrawn && (_budget_us != 0) &&
+			((uint32_t)micros() - start >= _budget_us) )
+		{
+			return false;
+		}
+		_damage.remove(i);
+		repaint(r);
+		*pdrawn = true;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// repaint
+//
+// Clears a region and redraws every panel overlapping it, clipped to it
+//
+//-----------------------------------------------------------------------------
+void Menu::repaint( const Rect &r )
+{
+	Display *pdisplay = Panel::getDisplay();
+	pdisplay->setClip(r.x, r.y, r.w, r.h);
+	pdisplay->fillRect(r.x, r.y, r.w, r.h, BG_COLOR);
+	Panel *ppanel = _head;
+	while( ppanel != NULL )
+	{
+		if( ppanel->intersects(r) )
+		{
+			ppanel->draw();
+		}
+		ppanel = ppanel->getNext();
+	}
+	pdisplay->clearClip();
+}
+
+//-----------------------------------------------------------------------------
+// 
+// isOwned
+//
+// True when a finger's touch belongs to the panel
+//
+//-----------------------------------------------------------------------------
+bool Menu::isOwned( Panel *ppanel )
+{
+	for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+	{
+		if( _owner[f] == ppanel )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// isFlushed
+//
+// True when nothing is left over for the next flush()
+//
+//-----------------------------------------------------------------------------
+bool Menu::isFlushed( void )
+{
+	if( _damage.getCount() > 0 )
+	{
+		return false;
+	}
+	for( Panel *ppanel = _head; ppanel != NULL; ppanel = ppanel->getNext() )
+	{
+		if( ppanel->_pending || ppanel->_unpainted )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// scrollTo
+//
+// Moves the display's scroll and repaints the rows it brought into view,
+// everything else is already on screen
+//
+//-----------------------------------------------------------------------------
+void Menu::scrollTo( int16_t y )
+{
+	Display *pdisplay = Panel::getDisplay();
+	if( !pdisplay->isScrolling() )
+	{
+		return;
+	}
+	int16_t bottom = 0;
+	for( Panel *ppanel = _head; ppanel != NULL; ppanel = ppanel->getNext() )
+	{
+		if( ppanel->getY() + ppanel->getH() > bottom )
+		{
+			bottom = ppanel->getY() + ppanel->getH();
+		}
+	}
+	if( y > bottom - pdisplay->height() )
+	{
+		y = bottom - pdisplay->height();
+	}
+	if( y < 0 )
+	{
+		y = 0;
+	}
+	int16_t old = pdisplay->getScroll();
+	if( y == old )
+	{
+		return;
+	}
+	pdisplay->scrollTo(y);
+	_version++;
+	// content rows showing go from top + y to the height + y
+	int16_t top = pdisplay->getScrollTop();
+	int16_t h = pdisplay->height();
+	int16_t y0, y1;
+	if( y > old )
+	{
+		y0 = (h + old > top + y) ? h + old : top + y;
+		y1 = h + y;
+	}
+	else
+	{
+		y0 = top + y;
+		y1 = (top + old < h + y) ? top + old : h + y;
+	}
+	_damage.add(0, y0, pdisplay->width(), y1 - y0);
+	flush();
+}
+
+#ifdef PANEL_STATS
+//-----------------------------------------------------------------------------
+// 
+// resetStats
+//
+// Zeroes the counters of every panel
+//
+//-----------------------------------------------------------------------------
+void Menu::resetStats( void )
+{
+	Panel *ppanel = _head;
+	while( ppanel != NULL )
+	{
+		ppanel->resetStats();
+		ppanel = ppanel->getNext();
+	}
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// 
+// update
+//
+// Polls the touch backend, call from loop()
+// All the samples read are handled before anything is repainted, so the
+// display is written at most once per update
+//
+//-----------------------------------------------------------------------------
+void Menu::update( void )
+{
+	TouchPoint points[MENU_MAX_SAMPLES];
+	uint8_t n = 0;
+	if( _touch != NULL )
+	{
+		n = _touch->read(points, MENU_MAX_SAMPLES);
+	}
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		points[i].y = Panel::getDisplay()->toContent(points[i].y);
+	}
+	// one poll at a time, its points have rising ids
+	for( uint8_t i = 0, len; i < n; i += len )
+	{
+		len = 1;
+		while( (i + len < n) && (points[i + len].id > points[i + len - 1].id) )
+		{
+			len++;
+		}
+		touch(&points[i], len, _touch->isBuffered());
+	}
+	if( (n == 0) && (_touch != NULL) && !_touch->isBuffered() )
+	{
+		// nothing read straight from the screen, so every finger is up
+		for( uint8_t f = 0; f < MENU_MAX_TOUCHES; f++ )
+		{
+			if( _owner[f] != NULL )
+			{
+				release(f);
+			}
+		}
+	}
+	else if( n < MENU_MAX_SAMPLES )
+	{
+		// only time out once everything queued has been handled
+		hold(millis());
+	}
+	flush();
+}
+
+
+//-----------------------------------------------------------------------------
+// 
+// getTheta
+//
+// necessary in order to use the Knob class
+//
+//-----------------------------------------------------------------------------
+uint8_t getTheta( uint16_t x, uint16_t y, Panel* ppanel )
+{
+	uint8_t _r = ppanel->getMax();
+	// x and y relative to knob center, y flipped so the angle goes
+	// counterclockwise on screen
+	int16_t x_knob = (int16_t)x - (int16_t)(ppanel->getX() + _r);
+	int16_t y_knob = (int16_t)(ppanel->getY() + _r) - (int16_t)y;
+	// half a turn puts the start of the range on the left
+	return (uint16_t)(angleAtan2(y_knob, x_knob) + ANGLE_HALF) >> 8;
 }
\ No newline at end of file
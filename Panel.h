@@ -2,14 +2,17 @@
 #ifndef _panel_h_
 #define _panel_h_
 
-#include <Arduino.h>
+#include "PanelPort.h"
+#include "Display.h"
+#include "Damage.h"
+#include "Angle.h"
+#include "Gesture.h"
+#include "TouchSampler.h"
+#include "CallbackQueue.h"
+#include "PanelValue.h"
 
-#include <Adafruit_GFX.h>    // Core graphics library
-#include <SPI.h>       // needed for display
-#include <Adafruit_ILI9341.h>
-#include <Wire.h>      // needed for FT6206
-#include <Adafruit_FT6206.h>
-#include <avr/pgmspace.h> // needed for PROGMEME
+#ifdef ARDUINO
+#include "ILI9341Display.h"
 
 // The FT6206 uses hardware I2C (SCL/SDA)
 extern Adafruit_FT6206 ctp; // = Adafruit_FT6206(); 
@@ -19,6 +22,11 @@ extern Adafruit_FT6206 ctp; // = Adafruit_FT6206();
 #define TFT_DC 9
 extern Adafruit_ILI9341 tft; // = Adafruit_ILI9341(TFT_CS, TFT_DC); 
 
+// default backends, wrapping tft and ctp
+extern ILI9341Display tftDisplay;
+extern FT6206Touch ctpTouch;
+#endif // ARDUINO
+
 // screen size
 // ... don't really need both of these
 #define MAX_X 240
@@ -29,6 +37,75 @@ const uint16_t maxy = 320;
 // touch size
 #define PENRADIUS 3
 
+// uncomment to keep per panel counters, see PanelStats
+// has to be seen by the library too, so set it here or in the build flags
+//#define PANEL_STATS
+#if defined(PANEL_STATS) && !DISPLAY_STATS
+#error "PANEL_STATS needs DISPLAY_STATS"
+#endif
+
+// most touch samples handled per Menu::update()
+#ifndef MENU_MAX_SAMPLES
+#define MENU_MAX_SAMPLES 8
+#endif
+
+// touch lookup grid, cells are 1 << MENU_GRID_SHIFT pixels square
+// each cell holds a bit per panel, so only the first MENU_MAX_PANELS
+// panels are indexed, any more are found by walking the list
+// panels past the bottom of the screen wrap round to the top rows
+// AVR defaults to 16 panels in 128 pixel cells, 12 bytes of grid and 32
+// of panel pointers a menu, elsewhere 32 panels in 64 pixel cells
+#ifndef MENU_GRID_SHIFT
+#ifdef __AVR__
+#define MENU_GRID_SHIFT 7
+#else
+#define MENU_GRID_SHIFT 6
+#endif
+#endif
+#define MENU_GRID_COLS ((MAX_X + (1 << MENU_GRID_SHIFT) - 1) >> MENU_GRID_SHIFT)
+#define MENU_GRID_ROWS ((MAX_Y + (1 << MENU_GRID_SHIFT) - 1) >> MENU_GRID_SHIFT)
+#ifndef MENU_MAX_PANELS
+#ifdef __AVR__
+#define MENU_MAX_PANELS 16
+#else
+#define MENU_MAX_PANELS 32
+#endif
+#endif
+
+// a grid cell, the smallest word with a bit per indexed panel
+#if MENU_MAX_PANELS <= 8
+typedef uint8_t MenuCell;
+#elif MENU_MAX_PANELS <= 16
+typedef uint16_t MenuCell;
+#elif MENU_MAX_PANELS <= 32
+typedef uint32_t MenuCell;
+#else
+#error "MENU_MAX_PANELS can be at most 32"
+#endif
+
+// menus that can exist at once, at most 31
+// a panel finds its menu by its place in a table of them, 5 bits
+#ifndef MENU_MAX_MENUS
+#define MENU_MAX_MENUS 8
+#endif
+#if MENU_MAX_MENUS > 31
+#error "MENU_MAX_MENUS can be at most 31"
+#endif
+
+// panels in a Menu's arena start on multiples of this
+#define MENU_ARENA_ALIGN sizeof(void *)
+
+// samples in a Sketch's wavetable, at most 256
+#ifndef SKETCH_TABLE_LEN
+#define SKETCH_TABLE_LEN 256
+#endif
+
+// touch points a Sketch keeps for render(), more between two flushes
+// replace the last one, so one update's worth is never cut short
+#ifndef SKETCH_PENDING
+#define SKETCH_PENDING MENU_MAX_SAMPLES
+#endif
+
 // middle of screen needs to equal 127
 #define OFFSET 7
 
@@ -50,34 +127,132 @@ const uint16_t BG_COLOR = BLACK;
 const uint16_t FG_COLOR1 = WHITE;
 const uint16_t FG_COLOR2 = CYAN;
 const uint16_t FG_COLOR3 = PINK;
+//*****************************************************************************
+//
+// PanelStats
+//
+// What a panel cost, only kept when PANEL_STATS is defined
+// Times are in micros(), update_us leaves out the time spent in the method
+//
+//*****************************************************************************
+#ifdef PANEL_STATS
+struct PanelStats
+{
+	uint16_t draws; // calls to drawPanel()
+	// pixels drawPanel() and render() asked for, after clipping
+	uint32_t pixels;
+	uint16_t events; // touch events handled
+	uint32_t update_us; // time handling the events and rendering them
+	uint32_t method_us; // time in the bound method
+};
+#endif
+
 //*****************************************************************************
 //
 // Panel class
 // 
 // Parent class for all the GUI objects
 //
+// A Menu turns the touch samples into events for the panel the touch
+// started on: a press, moves while it's held, a long press and then
+// repeats if it's held still long enough, and a release.
+//
+// A panel calls its bound method before redrawing. With a CallbackQueue
+// set the method is posted instead, and runs when the sketch drains it.
+//
+// Handling an event only changes the panel's state. What that changes on
+// screen is either marked dirty, for the menu to repaint, or for panels
+// that know exactly which pixels moved, drawn by render() when the menu
+// flushes. Several events in one update are then drawn once.
+// Changes made from code, e.g. setValue(), go the same way, so a panel on
+// a page that isn't showing is only drawn once its own menu flushes.
+//
 //*****************************************************************************
+class Menu;
+
+
 //!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // FIX ME should add start position in constructor
 //!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 class Panel
 {
+	friend class Menu;
+	friend class CallbackQueue;
+	friend class Snapshot;
+
 	private:
-		bool _enable;
 		Panel *_next;
 		// child isn't always necessary, maybe remove for some applications?
 		Panel *_child;		
+#ifdef PANEL_STATS
+		PanelStats _stats;
+		void draw( void );
+		void handle( uint8_t event, uint16_t x, uint16_t y );
+		void redraw( void );
+		bool runMethod( uint16_t x, uint16_t y );
+#else
+		inline void draw( void ){ drawPanel(); }
+		inline void redraw( void ){ render(); }
+		inline void handle( uint8_t event, uint16_t x, uint16_t y ){
+			handleEvent(event, x, y); }
+		inline bool runMethod( uint16_t x, uint16_t y ){
+			return (*_method)(x, y, this); }
+#endif
 
 	protected:
-		// display is 240 x 320 so one dim could be uint8_t
-		uint16_t _x, _y, _w, _h; 
+		// every panel draws through the same display
+		static Display *_display;
+		// event being handled
+		static uint8_t _event;
+		// where methods are posted, NULL to call them right away
+		static CallbackQueue *_queue;
 		bool (*_method)(uint16_t x, uint16_t y, Panel *ppanel); 
+		// display is 240 x 320 so x and w fit in a byte, y and h don't,
+		// and with a scroll area y is a content row
+		uint16_t _y, _h; 
+		uint8_t _x, _w;
 		virtual void updatePanel( uint16_t x, uint16_t y  ) = 0;
+		virtual void handleEvent( uint8_t event, uint16_t x, uint16_t y );
+		// calls the bound method, or posts it when there's a queue
+		// value: only the latest of several moves matters, see post()
+		inline bool callMethod( uint16_t x, uint16_t y, bool value = false ){
+			if( (_queue != NULL) && _queue->post(this, x, y, _event, value) )
+				return true;
+			return runMethod(x, y); }
+		void markDirty( int16_t x, int16_t y, int16_t w, int16_t h );
+		// panels that draw their own changes do it here, see markPending()
+		virtual void render( void ){}
+		void markPending( void );
+		// render() can't draw straight onto pixels other panels share,
+		// overlapped() says when, repaint() draws everything there again
+		bool overlapped( const Rect &r );
+		void repaint( const Rect &r );
+		// render() at the next flush without drawing now, for state that
+		// changes outside a touch, e.g. from an interrupt
+		inline void deferRender( void ){ _pending = true; }
+		// what a Snapshot keeps, stateSize() bytes written by saveState()
+		virtual uint8_t stateSize( void ){ return 0; }
+		virtual void saveState( uint8_t *buf ){}
+		// takes a saved state without drawing, calling the method when
+		// that changes anything
+		virtual void loadState( const uint8_t *buf ){}
+
+	private:
+		// one byte after the geometry, so nothing is padded
+		uint8_t _enable : 1;
+		// render() is due at the next flush
+		uint8_t _pending : 1;
+		// left for flush() to draw by paintMenu()
+		uint8_t _unpainted : 1;
+		// menu the panel was added to, which draws its changes, as its
+		// place in the table of menus, 0 for none
+		uint8_t _menu : 5;
+		inline Menu* menu( void );
 
 	public:
 		Panel( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel) );
-		~Panel();
+		virtual ~Panel();
 		virtual void drawPanel( void ) = 0;
 		bool isTouched( uint16_t x, uint16_t y );
 		// inline functions
@@ -85,6 +260,10 @@ class Panel
 		inline uint16_t getY( void ){ return _y; }
 		inline uint16_t getW( void ){ return _w; }
 		inline uint16_t getH( void ){ return _h; }
+		inline bool contains( uint16_t x, uint16_t y ){ return _enable &&
+			(x >= _x) && (x < _x + _w) && (y >= _y) && (y < _y + _h); }
+		inline bool intersects( const Rect &r ){ return (r.x < _x + _w) &&
+			(_x < r.x + r.w) && (r.y < _y + _h) && (_y < r.y + r.h); }
 		inline Panel* getNext( void ){ return _next; }
 		inline void setNext( Panel *ppanel ){ _next = ppanel; }
 		// Child is a panel controlled by this panel
@@ -95,6 +274,20 @@ class Panel
 		inline void setEnable( bool en ){ _enable = en; }
 		inline virtual uint8_t getMin( void ){ return -1; }
 		inline virtual uint8_t getMax( void ){ return -1; }
+		// display backend, defaults to tftDisplay on the board
+		// host builds must set one before drawing
+		static inline Display* getDisplay( void ){ return _display; }
+		static inline void setDisplay( Display *pdisplay ){ _display = pdisplay; }
+		// TouchEvent that led to the current callback
+		static inline uint8_t getEvent( void ){ return _event; }
+		// bound methods are posted to the queue instead of called
+		static inline CallbackQueue* getQueue( void ){ return _queue; }
+		static inline void setQueue( CallbackQueue *pqueue ){ _queue = pqueue; }
+#ifdef PANEL_STATS
+		inline const PanelStats& getStats( void ){ return _stats; }
+		inline void resetStats( void ){ _stats.draws = 0; _stats.pixels = 0;
+			_stats.events = 0; _stats.update_us = 0; _stats.method_us = 0; }
+#endif
 }; 
 
 //*****************************************************************************
@@ -107,14 +300,23 @@ class Button: public Panel
 	private:
 		uint16_t _color;
 		void updatePanel( uint16_t x, uint16_t y  ); 
+		void handleEvent( uint8_t event, uint16_t x, uint16_t y );
 		bool _state;
-		unsigned long _old_millis = 0;
+		// call the method again on long press and repeats
+		bool _repeat;
+
+	protected:
+		inline uint8_t stateSize( void ){ return 1; }
+		inline void saveState( uint8_t *buf ){ buf[0] = _state; }
+		void loadState( const uint8_t *buf );
 
 	public:
 		Button( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color );
 		void drawPanel( void );
+		inline bool getState( void ){ return _state; }
+		inline void setRepeat( bool repeat ){ _repeat = repeat; }
 
 };
 
@@ -125,31 +327,47 @@ class Button: public Panel
 // creates fader parallel to x axis
 // use for increasing / decreasing effect or signal
 //
+// Its value goes from the left end to the right, see PanelValue. A touch
+// that doesn't change the value doesn't move the fader or call the method.
+//
 //*****************************************************************************
 class Fader: public Panel
 {
 	private:
-		const uint8_t _border = 2; // potentially unnecessary
+		static const uint8_t _border = 2; // potentially unnecessary
+		// width of fader graphic, its height follows the panel's
+		static const uint8_t _x_dim = 60;
 		uint16_t _color;
-		// bottom point of fader
-		uint8_t _value;
-		// dimensions of fader graphic
-		const uint8_t _x_dim = 60;
-		uint8_t _y_dim;
-		// min and max x values of fader
-		uint8_t _min; // lowest center of fader
-		uint8_t _max; // highest center of fader
-		// save old position so less needs to be erased
-		uint16_t _old_val;
+		PanelValue _value;
+		// left edge of the fader
+		uint8_t _pos;
+		// lowest and highest center of fader, from the panel's geometry
+		inline uint8_t lo( void ){ return _x + _x_dim/2 + _border; }
+		inline uint8_t hi( void ){ return _x + _w - (_x_dim/2 + _border); }
+		inline uint8_t yDim( void ){ return _h - 2 * _border; }
 		void updatePanel( uint16_t x, uint16_t y  ); 
+		uint8_t columnAt( uint8_t pos, uint16_t col );
+		void moveColumn( uint16_t col, uint8_t from, uint8_t to );
+		void moveTo( uint8_t pos );
+
+	protected:
+		void render( void );
+		inline uint8_t stateSize( void ){ return 2; }
+		void saveState( uint8_t *buf );
+		void loadState( const uint8_t *buf );
 
 	public:
 		Fader( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color );
 		void drawPanel( void );
-		inline uint8_t getMin(void) { return _min; }
-		inline uint8_t getMax(void) { return _max; }
+		void setRange( int16_t lo, int16_t hi, uint16_t step = 1,
+			uint16_t hysteresis = 0 );
+		void setValue( int16_t value );
+		inline uint8_t getMin(void) { return lo(); }
+		inline uint8_t getMax(void) { return hi(); }
+		// by default the pixels the center can move, 0 on the left
+		inline int16_t getValue( void ){ return _value.get(); }
 };
 
 //*****************************************************************************
@@ -158,19 +376,55 @@ class Fader: public Panel
 //
 // creates a place for user to draw input 
 //
+// What's drawn is kept as a wavetable: one sample per slice of the width,
+// 0 at the bottom to 255 at the top, starting flat in the middle. Each
+// stroke only rewrites the samples it crosses, filling in any it skipped
+// over by interpolating. getTable() hands out the table itself, so e.g.
+// an audio interrupt can play it without a copy being made.
+//
 //*****************************************************************************
+// point of a stroke waiting to be drawn, start is set where the pen
+// went down
+struct SketchPoint
+{
+	uint8_t x;
+	bool start;
+	uint16_t y;
+};
+
 class Sketch: public Panel
 {
 	private:
 		uint16_t _color;
+		// pen is down at _pen_x, _pen_y
 		bool _state;
+		uint16_t _pen_x, _pen_y;
+		// strokes not drawn yet, and the last point drawn
+		SketchPoint _points[SKETCH_PENDING];
+		uint8_t _count;
+		uint16_t _ink_x, _ink_y;
+		uint8_t _table[SKETCH_TABLE_LEN];
+		// bumped every time the table changes, 32 bits so it can't wrap
+		// round to a value a caller still holds
+		uint32_t _version;
 		void updatePanel( uint16_t x, uint16_t y  ); 
+		void handleEvent( uint8_t event, uint16_t x, uint16_t y );
+		void render( void );
+		void stroke( int16_t x0, int16_t y0, int16_t x1, int16_t y1 );
+		void capture( int16_t x0, int16_t y0, int16_t x1, int16_t y1 );
+		int16_t toIndex( int16_t x );
+		uint8_t toSample( int16_t y );
 
 	public:
 		Sketch( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color );
 		void drawPanel( void );
+		void clearTable( void );
+		// inline functions
+		inline const uint8_t* getTable( void ){ return _table; }
+		inline uint16_t getTableLen( void ){ return SKETCH_TABLE_LEN; }
+		inline uint32_t getVersion( void ){ return _version; }
 
 };
 //*****************************************************************************
@@ -180,26 +434,125 @@ class Sketch: public Panel
 // Creates a knob, starts at middle position 
 // ideal for blending between two signals
 //
+// Moving the mark doesn't go through the menu's repaint: the old and new
+// spots are sent as one sprite, the mark over the ring and background
+// worked out a pixel at a time, in a single window.
+//
+// Its value goes once round counterclockwise from the left, 0 to 255 by
+// default like getTheta(), and the mark sits where the value is. A touch
+// that doesn't change the value doesn't move it or call the method.
+//
 //*****************************************************************************
+// widest and tallest window the mark is moved in, one bit per column
+#define KNOB_SPRITE_MAX 16
+// angles are tracked to 12 bits, a turn is KNOB_TURN
+#define KNOB_ANGLE_SHIFT 4
+#define KNOB_TURN (0x10000L >> KNOB_ANGLE_SHIFT)
+
 class Knob: public Panel
 {
 	private:
+		static const uint8_t _border = 2; 
 		uint16_t _color;
-		bool _state;
-		const uint8_t _border = 2; 
+		// position of the mark, erased on the next update
+		uint16_t _xplot; 
+		uint16_t _yplot;
+		PanelValue _value;
 		uint8_t _r;
-		uint16_t _r2;
-		// save old position so less will need to be erased
-		uint16_t _old_xplot; 
-		uint16_t _old_yplot;
 		void updatePanel( uint16_t x, uint16_t y  ); 
+		void markAt( uint16_t *pxplot, uint16_t *pyplot );
+		void bakeRing( int16_t x, int16_t y, uint8_t h, uint16_t *rows );
+		void blitMark( int16_t x, int16_t y, uint8_t w, uint8_t h );
+
+	protected:
+		void render( void );
+		inline uint8_t stateSize( void ){ return 2; }
+		void saveState( uint8_t *buf );
+		void loadState( const uint8_t *buf );
 
 	public:
 		Knob( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
 			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
 			uint16_t color );
 		void drawPanel( void );
+		void setRange( int16_t lo, int16_t hi, uint16_t step = 1,
+			uint16_t hysteresis = 0 );
+		void setValue( int16_t value );
 		inline uint8_t getMax(void) { return _r; }
+		inline int16_t getValue( void ){ return _value.get(); }
+};
+
+//*****************************************************************************
+//
+// Graph class
+//
+// Plots a stream of samples, e.g. audio or a control signal, sweeping
+// left to right and wrapping round like a scope. push() can be called as
+// fast as samples come in, from an interrupt too: it only keeps the lowest
+// and highest of every setDecimation() samples, and when a column's worth
+// is in, hands that envelope to the menu. It never draws or allocates.
+//
+// The envelopes wait in a short queue until the menu flushes, and render()
+// only draws the rows where the column's new envelope differs from the one
+// it replaces. If the screen falls behind and the queue fills up, the
+// column being collected just keeps taking samples until there's room.
+//
+//*****************************************************************************
+// envelopes kept, a graph wider than this plots columns a few pixels wide
+// two bytes each
+#ifndef GRAPH_MAX_COLS
+#define GRAPH_MAX_COLS 120
+#endif
+// columns waiting for the menu to draw them, a power of 2
+#ifndef GRAPH_BACKLOG
+#define GRAPH_BACKLOG 8
+#endif
+
+class Graph: public Panel
+{
+	private:
+		uint16_t _color;
+		int16_t _lo, _hi;
+		// samples per column, and the column being collected
+		uint16_t _decimation;
+		uint16_t _count;
+		int16_t _min, _max;
+		// columns and their width in pixels, the next one to draw
+		uint8_t _cols;
+		uint8_t _col_w;
+		uint8_t _col;
+		// rows each column shows, counted from the top inside the border
+		// nothing is shown when top is below bottom
+		uint8_t _top[GRAPH_MAX_COLS];
+		uint8_t _bottom[GRAPH_MAX_COLS];
+		// envelopes pushed but not drawn yet, indices wrap at 256
+		uint8_t _queue_top[GRAPH_BACKLOG];
+		uint8_t _queue_bottom[GRAPH_BACKLOG];
+		uint8_t _head, _tail;
+		void updatePanel( uint16_t x, uint16_t y  ); 
+		uint8_t toRow( int16_t sample );
+		void drawColumn( uint8_t c, uint8_t top, uint8_t bottom );
+		void drawRows( uint8_t c, int16_t top, int16_t bottom,
+			uint16_t color );
+
+	protected:
+		void render( void );
+
+	public:
+		Graph( uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+			bool (*method)(uint16_t x, uint16_t y, Panel *ppanel), 
+			uint16_t color );
+		void drawPanel( void );
+		void push( int16_t sample );
+		void push( const int16_t *samples, uint16_t n );
+		void clear( void );
+		// samples from lo to hi fill the height, applies to new columns
+		inline void setRange( int16_t lo, int16_t hi ){ _lo = lo;
+			_hi = (hi > lo) ? hi : lo + 1; }
+		inline void setDecimation( uint16_t samples ){
+			_decimation = (samples > 0) ? samples : 1; }
+		inline uint16_t getDecimation( void ){ return _decimation; }
+		inline uint8_t getColumns( void ){ return _cols; }
 };
 
 //*****************************************************************************
@@ -211,30 +564,194 @@ class Knob: public Panel
 // isTouched() and drawPanel() functions at the same time, as well as group 
 // different menus together
 //
+// Samples are turned into TouchEvents. A touch belongs to the panel it was
+// pressed on until it's released: either the backend reports nothing, or
+// for buffered backends no sample came in for the release time.
+//
+// Each finger has its own touch, so with two fingers down two panels get
+// events from the same poll, e.g. two faders moved at once. A poll that
+// has one finger fewer than the last releases the touch it lost.
+//
+// flush() can be given a time budget, so a burst of touches can't keep
+// loop() drawing for long. Once the budget is spent the rest waits for
+// the next flush, and the panels under a finger are always drawn first.
+// The check is made between panels and regions, so a flush can run over
+// by one of them.
+//
+// Panels can go on past the bottom of the screen when the display has a
+// scroll area. scrollTo() moves the controller's scroll and only redraws
+// the rows that came into view, and touches are turned into content rows
+// before they're handled.
+//
+// Panels can either be allocated by the sketch and added with addPanel(),
+// in which case the menu deletes them, or built in the menu's arena with
+// create(). Arena panels never touch the heap and are all released at
+// once by clear(), so a page can be torn down and rebuilt forever without
+// fragmenting memory.
+//
+// Panels find their menu through a table of the menus that exist, which
+// holds MENU_MAX_MENUS. Past that a menu still works, but its panels draw
+// their changes right away, the way panels outside of any menu do.
+//
 //*****************************************************************************
 class Menu
 {
+	friend class Panel;
+
 	private:
 		Panel *_head;
 		Panel *_tail;
+		// arena panels are built in, and how much of it is in use
+		uint8_t *_arena;
+		uint16_t _arena_size;
+		uint16_t _arena_used;
+		// panels added with addPanel() that have to be deleted
+		uint8_t _heap;
+		TouchInput *_touch;
+		// regions to repaint on the next flush()
+		Damage _damage;
+		// panels indexed by the grid, in the order they were added
+		Panel *_panels[MENU_MAX_PANELS];
+		uint8_t _count;
+		// bit i of a cell is set if _panels[i] overlaps the cell
+		MenuCell _grid[MENU_GRID_ROWS][MENU_GRID_COLS];
+		// first panel that didn't fit in the index
+		Panel *_overflow;
+		// touch of each finger, _owner is NULL when that finger is up
+		Panel *_owner[MENU_MAX_TOUCHES];
+		Gesture _gesture[MENU_MAX_TOUCHES];
+		// bumped whenever the page may look different, 32 bits so it
+		// can't wrap round to the version a cache was made at
+		uint32_t _version;
+		// most time flush() spends drawing, 0 for no limit
+		uint16_t _budget_us;
+		// every menu there is, by the index its panels keep, 0 is none
+		static Menu *_menus[MENU_MAX_MENUS + 1];
+		uint8_t _index;
+		void enlist( void );
+		Panel* find( uint16_t x, uint16_t y );
+		bool isOwned( Panel *ppanel );
+		bool flushSome( bool owned, uint32_t start, bool *pdrawn,
+			bool *ppainted );
+		void repaint( const Rect &r );
+		void deliver( uint8_t finger, uint8_t event, uint16_t x, uint16_t y );
+		void touch( const TouchPoint *points, uint8_t n, bool buffered );
+		void press( const TouchPoint &p );
+		void hold( uint32_t now );
+		void release( uint8_t finger );
+		void reset( void );
+		void link( Panel *ppanel );
+		inline bool inArena( Panel *ppanel ){ return ((uint8_t *)ppanel >=
+			_arena) && ((uint8_t *)ppanel < _arena + _arena_size); }
 
 	public:
 		Menu();
+		Menu( uint8_t *arena, uint16_t size );
 		~Menu();
 		void addPanel( Panel *ppanel );
+		void clear( void );
+		// builds a panel in the arena and adds it
+		// returns NULL when the arena is full
+		template <class T, class... Args>
+		T* create( Args... args )
+		{
+			if( _arena_used + footprint<T>() > _arena_size )
+			{
+				return NULL;
+			}
+			T *ppanel = new (_arena + _arena_used) T(args...);
+			_arena_used += footprint<T>();
+			link(ppanel);
+			return ppanel;
+		}
+		// arena bytes a panel takes, usable in static_assert()
+		template <class T>
+		static constexpr uint16_t footprint( void )
+		{
+			return (sizeof(T) + MENU_ARENA_ALIGN - 1) &
+				~(MENU_ARENA_ALIGN - 1);
+		}
+		inline uint16_t getArenaSize( void ){ return _arena_size; }
+		inline uint16_t getArenaUsed( void ){ return _arena_used; }
 		void drawMenu( void );
+		// drawMenu() a panel at a time from update(), touches are handled
+		// in between
+		void paintMenu( void );
 		void isTouched( uint16_t x, uint16_t y );
+		void isReleased( void );
+		// reads the touch backend, handles every sample and flushes once
+		void update( void );
+		void flush( void );
+		bool isFlushed( void );
+		// shows content row top + y at the top of the display's scroll
+		// area, y stops at the bottom of the lowest panel
+		void scrollTo( int16_t y );
+		inline void scrollBy( int16_t dy ){
+			scrollTo(Panel::getDisplay()->getScroll() + dy); }
+		// touch backend, defaults to ctpTouch on the board
+		inline TouchInput* getTouch( void ){ return _touch; }
+		inline void setTouch( TouchInput *ptouch ){ _touch = ptouch; }
+		// a long press or repeat time of 0 turns them off
+		inline void setTiming( uint16_t release_ms, uint16_t long_press_ms,
+			uint16_t repeat_ms ){ for( uint8_t f = 0; f < MENU_MAX_TOUCHES;
+			f++ ) _gesture[f].setTiming(release_ms, long_press_ms,
+			repeat_ms); }
+		// first panel, walk the rest with getNext()
+		inline Panel* getHead( void ){ return _head; }
+		// changes when panels are added or removed, handle a touch or are
+		// changed from code
+		inline uint32_t getVersion( void ){ return _version; }
+		// what doesn't fit in the budget is left for the next flush()
+		inline uint16_t getBudget( void ){ return _budget_us; }
+		inline void setBudget( uint16_t budget_us ){ _budget_us = budget_us; }
+#ifdef PANEL_STATS
+		void resetStats( void );
+#endif
 
 };
 
+//-----------------------------------------------------------------------------
+//
+// menu
+//
+// Menu the panel is in, NULL for none
+//
+//-----------------------------------------------------------------------------
+inline Menu* Panel::menu( void )
+{
+	return Menu::_menus[_menu];
+}
+
+//*****************************************************************************
+//
+// PageMenu class
+//
+// Menu with its own arena of N bytes, so its whole footprint is sizeof()
+// e.g. for a page of four faders and a knob:
+//   static_assert( 4 * Menu::footprint<Fader>() + Menu::footprint<Knob>()
+//       <= 128, "page doesn't fit" );
+//   PageMenu<128> page;
+//
+//*****************************************************************************
+template <uint16_t N>
+class PageMenu: public Menu
+{
+	private:
+		alignas(MENU_ARENA_ALIGN) uint8_t _storage[N];
+
+	public:
+		PageMenu( void ) : Menu(_storage, N) {}
+};
+
 //-----------------------------------------------------------------------------
 // 
 // getTheta( x, y, Panel* )
 //
-// returns theta value [0,255] for ind = false
-// returns index to asin21 [0, 20] for ind = true
+// returns theta value [0,255] of a touch around a knob, going
+// counterclockwise from the left: 64 at the bottom, 128 at the right (the
+// middle position) and 192 at the top
 //
 //-----------------------------------------------------------------------------
-uint8_t getTheta( uint16_t x, uint16_t y, Panel *ppanel, bool ind = false );
+uint8_t getTheta( uint16_t x, uint16_t y, Panel *ppanel );
 
 #endif // _panel_h_
@@ -0,0 +1,56 @@
+#ifndef _panel_port_h_
+#define _panel_port_h_
+
+//*****************************************************************************
+//
+// Portability layer
+//
+// Everything above the display / touch backends is plain C++, so the library
+// can also be built on a host (e.g. a build server running benchmarks
+// against the framebuffer backend). Host builds get small stand-ins for the
+// handful of Arduino functions the library uses.
+//
+//*****************************************************************************
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <avr/pgmspace.h> // needed for PROGMEM
+#ifdef __AVR__
+#include <new.h> // placement new
+#else
+#include <new>
+#endif
+
+#else // host build
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <new>
+
+#define PROGMEM
+#define pgm_read_byte_near(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word_near(addr) (*(const uint16_t *)(addr))
+
+// time since first call, like time since boot on the board
+inline unsigned long micros( void )
+{
+	static const std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis( void )
+{
+	return micros() / 1000;
+}
+
+inline long map( long x, long in_min, long in_max, long out_min, long out_max )
+{
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#endif // ARDUINO
+
+#endif // _panel_port_h_
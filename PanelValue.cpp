@@ -0,0 +1,129 @@
+#include "PanelValue.h"
+
+//*****************************************************************************
+//
+// PanelValue class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+// Every value from lo to hi, starting at lo
+//
+//-----------------------------------------------------------------------------
+PanelValue::PanelValue( int16_t lo, int16_t hi )
+{
+	_value = lo;
+	setRange(lo, hi, 1, 0);
+}
+
+//-----------------------------------------------------------------------------
+//
+// setRange
+//
+// hi has to be above lo, a step of 0 is taken as 1
+// The value is moved onto the new range
+//
+//-----------------------------------------------------------------------------
+void PanelValue::setRange( int16_t lo, int16_t hi, uint16_t step,
+			uint16_t hysteresis )
+{
+	_lo = lo;
+	_hi = hi > lo ? hi : lo + 1;
+	_step = step > 0 ? step : 1;
+	_hysteresis = hysteresis;
+	_value = quantize(_value);
+}
+
+//-----------------------------------------------------------------------------
+//
+// quantize
+//
+// Nearest step to value that's in the range
+//
+//-----------------------------------------------------------------------------
+int16_t PanelValue::quantize( int32_t value )
+{
+	if( value <= _lo )
+	{
+		return _lo;
+	}
+	if( value > _hi )
+	{
+		value = _hi;
+	}
+	uint16_t steps = ((uint32_t)(value - _lo) + _step/2) / _step;
+	// the last step may not land on hi
+	if( _lo + (int32_t)steps * _step > _hi )
+	{
+		steps--;
+	}
+	return _lo + (int32_t)steps * _step;
+}
+
+//-----------------------------------------------------------------------------
+//
+// track
+//
+// Follows a touch at pos out of span along the panel, lo at 0 and hi at
+// span, returns true when the value changed
+// span can be up to 4096 with the full 16 bit range
+//
+//-----------------------------------------------------------------------------
+bool PanelValue::track( uint16_t pos, uint16_t span )
+{
+	if( span == 0 )
+	{
+		return false;
+	}
+	if( pos > span )
+	{
+		pos = span;
+	}
+	// both sides scaled by span, so nothing is rounded until the end
+	uint32_t range = (int32_t)_hi - _lo;
+	uint32_t touch = (uint32_t)pos * range;
+	uint32_t now = (uint32_t)((int32_t)_value - _lo) * span;
+	uint32_t moved = touch > now ? touch - now : now - touch;
+	int16_t value = quantize(_lo + (int32_t)((touch + span/2) / span));
+	if( (value == _value) ||
+		(2 * moved <= ((uint32_t)_step + 2 * _hysteresis) * span) )
+	{
+		return false;
+	}
+	_value = value;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// set
+//
+// Returns true when the value changed
+//
+//-----------------------------------------------------------------------------
+bool PanelValue::set( int16_t value )
+{
+	value = quantize(value);
+	if( value == _value )
+	{
+		return false;
+	}
+	_value = value;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// position
+//
+// Where the value sits out of span, the other way from track()
+//
+//-----------------------------------------------------------------------------
+uint16_t PanelValue::position( uint16_t span )
+{
+	uint32_t range = (int32_t)_hi - _lo;
+	return ((uint32_t)((int32_t)_value - _lo) * span + range/2) / range;
+}
@@ -0,0 +1,42 @@
+#ifndef _panel_value_h_
+#define _panel_value_h_
+
+#include "PanelPort.h"
+
+//*****************************************************************************
+//
+// PanelValue class
+//
+// The value a Fader or Knob stands for, between lo and hi in multiples of
+// step from lo. The panel hands in where the touch is along its travel
+// and only moves or calls its method when the value actually changes.
+//
+// Hysteresis keeps a finger resting on the boundary between two steps
+// from flipping back and forth: the touch has to go that much further
+// than half a step past the current value before it changes.
+//
+//*****************************************************************************
+class PanelValue
+{
+	private:
+		int16_t _lo, _hi;
+		uint16_t _step;
+		uint16_t _hysteresis;
+		int16_t _value;
+		int16_t quantize( int32_t value );
+
+	public:
+		PanelValue( int16_t lo, int16_t hi );
+		void setRange( int16_t lo, int16_t hi, uint16_t step,
+			uint16_t hysteresis );
+		bool track( uint16_t pos, uint16_t span );
+		bool set( int16_t value );
+		uint16_t position( uint16_t span );
+		// inline functions
+		inline int16_t get( void ){ return _value; }
+		inline int16_t getLo( void ){ return _lo; }
+		inline int16_t getHi( void ){ return _hi; }
+		inline uint16_t getStep( void ){ return _step; }
+};
+
+#endif // _panel_value_h_
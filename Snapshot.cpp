@@ -0,0 +1,357 @@
+#include "Snapshot.h"
+
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+//-----------------------------------------------------------------------------
+//
+// crc8
+//
+// CRC-8 with polynomial 0x07, carried on from crc
+//
+//-----------------------------------------------------------------------------
+static uint8_t crc8( uint8_t crc, uint8_t b )
+{
+	crc ^= b;
+	for( uint8_t i = 0; i < 8; i++ )
+	{
+		crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+	return crc;
+}
+
+
+//*****************************************************************************
+//
+// Snapshot class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+Snapshot::Snapshot( PageStore &store ) :
+			_store(store)
+{
+	_slot = SNAPSHOT_NONE;
+	_seq = 0;
+	_found = false;
+	_version = 0;
+	_changed = 0;
+	_dirty = false;
+}
+
+//-----------------------------------------------------------------------------
+//
+// pack
+//
+// Saves the state of every panel into buf, returns its length
+// shape is a check over how many bytes each panel keeps, so records of a
+// different menu don't match
+//
+//-----------------------------------------------------------------------------
+uint8_t Snapshot::pack( Menu &menu, uint8_t *buf, uint8_t *pshape )
+{
+	uint8_t len = 0;
+	uint8_t shape = 0;
+	for( Panel *ppanel = menu.getHead(); ppanel != NULL;
+		ppanel = ppanel->getNext() )
+	{
+		uint8_t n = ppanel->stateSize();
+		if( n == 0 )
+		{
+			continue;
+		}
+		// what doesn't fit isn't kept
+		if( len + n > SNAPSHOT_MAX_BYTES )
+		{
+			break;
+		}
+		ppanel->saveState(buf + len);
+		len += n;
+		shape = crc8(shape, n);
+	}
+	*pshape = shape;
+	return len;
+}
+
+//-----------------------------------------------------------------------------
+//
+// readSlot
+//
+// Reads the payload of a slot into buf, false unless it holds a whole
+// record for this menu
+//
+//-----------------------------------------------------------------------------
+bool Snapshot::readSlot( uint16_t slot, uint8_t len, uint8_t shape,
+	uint8_t *buf, uint16_t *pseq )
+{
+	uint32_t addr = (uint32_t)slot * SNAPSHOT_SLOT_BYTES(len);
+	uint8_t crc = 0;
+	uint8_t header[SNAPSHOT_HEADER_BYTES];
+	for( uint8_t i = 0; i < SNAPSHOT_HEADER_BYTES; i++ )
+	{
+		header[i] = _store.read(addr++);
+		crc = crc8(crc, header[i]);
+	}
+	if( (header[2] != shape) || (header[3] != len) )
+	{
+		return false;
+	}
+	for( uint8_t i = 0; i < len; i++ )
+	{
+		buf[i] = _store.read(addr++);
+		crc = crc8(crc, buf[i]);
+	}
+	if( _store.read(addr) != crc )
+	{
+		return false;
+	}
+	*pseq = header[0] | (header[1] << 8);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// find
+//
+// Looks through every slot for the newest record, the one whose sequence
+// number is ahead of all the others
+//
+//-----------------------------------------------------------------------------
+void Snapshot::find( Menu &menu )
+{
+	uint8_t buf[SNAPSHOT_MAX_BYTES];
+	uint8_t shape;
+	uint8_t len = pack(menu, buf, &shape);
+	uint16_t slots = _store.size() / SNAPSHOT_SLOT_BYTES(len);
+	_slot = SNAPSHOT_NONE;
+	for( uint16_t slot = 0; slot < slots; slot++ )
+	{
+		uint16_t seq;
+		if( readSlot(slot, len, shape, buf, &seq) &&
+			((_slot == SNAPSHOT_NONE) || ((int16_t)(seq - _seq) > 0)) )
+		{
+			_slot = slot;
+			_seq = seq;
+		}
+	}
+	_found = true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// restore
+//
+// Puts the panels back the way the newest record has them, false when
+// there's no record for this menu
+// Nothing is drawn, the panels that changed are marked dirty, so the
+// menu's version moves on and a menu already showing repaints them at its
+// next flush. Before drawMenu() that costs nothing extra.
+//
+//-----------------------------------------------------------------------------
+bool Snapshot::restore( Menu &menu )
+{
+	find(menu);
+	if( _slot == SNAPSHOT_NONE )
+	{
+		return false;
+	}
+	uint8_t was[SNAPSHOT_MAX_BYTES];
+	uint8_t buf[SNAPSHOT_MAX_BYTES];
+	uint8_t shape;
+	uint8_t len = pack(menu, was, &shape);
+	uint16_t seq;
+	readSlot(_slot, len, shape, buf, &seq);
+	Panel::_event = TOUCH_RESTORE;
+	len = 0;
+	for( Panel *ppanel = menu.getHead(); ppanel != NULL;
+		ppanel = ppanel->getNext() )
+	{
+		uint8_t n = ppanel->stateSize();
+		if( n == 0 )
+		{
+			continue;
+		}
+		if( len + n > SNAPSHOT_MAX_BYTES )
+		{
+			break;
+		}
+		bool same = true;
+		for( uint8_t i = len; i < len + n; i++ )
+		{
+			same &= (was[i] == buf[i]);
+		}
+		if( !same )
+		{
+			ppanel->loadState(buf + len);
+			ppanel->markDirty(ppanel->_x, ppanel->_y, ppanel->_w, ppanel->_h);
+		}
+		len += n;
+	}
+	Panel::_event = TOUCH_NO_EVENT;
+	_version = menu.getVersion();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// save
+//
+// Writes the panels' state into the slot after the newest, returns false
+// when it's the same as the newest record and nothing was written
+// The check byte goes last, so a save cut short by a power loss leaves
+// the record before it the newest
+//
+//-----------------------------------------------------------------------------
+bool Snapshot::save( Menu &menu )
+{
+	if( !_found )
+	{
+		find(menu);
+	}
+	uint8_t buf[SNAPSHOT_MAX_BYTES];
+	uint8_t shape;
+	uint8_t len = pack(menu, buf, &shape);
+	uint16_t slots = _store.size() / SNAPSHOT_SLOT_BYTES(len);
+	if( slots == 0 )
+	{
+		return false;
+	}
+	if( (_slot != SNAPSHOT_NONE) && (_slot < slots) )
+	{
+		uint8_t old[SNAPSHOT_MAX_BYTES];
+		uint16_t seq;
+		bool same = readSlot(_slot, len, shape, old, &seq);
+		for( uint8_t i = 0; same && (i < len); i++ )
+		{
+			same = (old[i] == buf[i]);
+		}
+		if( same )
+		{
+			return false;
+		}
+	}
+	uint16_t slot = ((_slot == SNAPSHOT_NONE) || (_slot + 1 >= slots)) ?
+		0 : _slot + 1;
+	uint16_t seq = _seq + 1;
+	uint8_t header[SNAPSHOT_HEADER_BYTES] = { (uint8_t)seq,
+		(uint8_t)(seq >> 8), shape, len };
+	uint32_t addr = (uint32_t)slot * SNAPSHOT_SLOT_BYTES(len);
+	uint8_t crc = 0;
+	for( uint8_t i = 0; i < SNAPSHOT_HEADER_BYTES; i++ )
+	{
+		_store.write(addr++, header[i]);
+		crc = crc8(crc, header[i]);
+	}
+	for( uint8_t i = 0; i < len; i++ )
+	{
+		_store.write(addr++, buf[i]);
+		crc = crc8(crc, buf[i]);
+	}
+	_store.write(addr, crc);
+	_slot = slot;
+	_seq = seq;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// update
+//
+// Saves once the menu has been left alone for SNAPSHOT_SETTLE_MS, so a
+// fader being dragged is written once it stops rather than every step
+//
+//-----------------------------------------------------------------------------
+void Snapshot::update( Menu &menu )
+{
+	uint32_t now = millis();
+	if( menu.getVersion() != _version )
+	{
+		_version = menu.getVersion();
+		_changed = now;
+		_dirty = true;
+	}
+	else if( _dirty && (now - _changed >= SNAPSHOT_SETTLE_MS) )
+	{
+		save(menu);
+		_dirty = false;
+	}
+}
+
+#ifndef ARDUINO
+
+//*****************************************************************************
+//
+// FileStore class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+// Reads what the file holds. A file that is missing, cut short or of
+// another size isn't trusted, the store starts erased.
+//
+//-----------------------------------------------------------------------------
+FileStore::FileStore( const char *path, uint32_t size ) :
+			_path(path)
+{
+	_size = size < FILE_STORE_MAX ? size : FILE_STORE_MAX;
+	_writes = 0;
+	FILE *fp = fopen(_path, "rb");
+	bool whole = false;
+	if( fp != NULL )
+	{
+		whole = (fread(_buf, 1, _size, fp) == _size) && (fgetc(fp) == EOF);
+		fclose(fp);
+	}
+	if( !whole )
+	{
+		for( uint32_t i = 0; i < _size; i++ )
+		{
+			_buf[i] = 0xFF;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// write
+//
+// Only the byte that changed goes to the file. The first write makes the
+// file, the whole image at once.
+//
+//-----------------------------------------------------------------------------
+bool FileStore::write( uint32_t addr, uint8_t b )
+{
+	if( addr >= _size )
+	{
+		return false;
+	}
+	if( _buf[addr] == b )
+	{
+		return true;
+	}
+	_buf[addr] = b;
+	_writes++;
+	FILE *fp = fopen(_path, "r+b");
+	if( fp == NULL )
+	{
+		fp = fopen(_path, "wb");
+		if( fp == NULL )
+		{
+			return false;
+		}
+		bool ok = fwrite(_buf, 1, _size, fp) == _size;
+		return (fclose(fp) == 0) && ok;
+	}
+	bool ok = (fseek(fp, addr, SEEK_SET) == 0) && (fputc(b, fp) != EOF);
+	return (fclose(fp) == 0) && ok;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,134 @@
+#ifndef _snapshot_h_
+#define _snapshot_h_
+
+#include "Panel.h"
+#include "PageStore.h"
+
+// most bytes of widget state a snapshot holds
+#ifndef SNAPSHOT_MAX_BYTES
+#define SNAPSHOT_MAX_BYTES 64
+#endif
+// how long a menu has to be left alone before update() saves it
+#ifndef SNAPSHOT_SETTLE_MS
+#define SNAPSHOT_SETTLE_MS 2000
+#endif
+// sequence number, shape and length in front, check byte behind
+#define SNAPSHOT_HEADER_BYTES 4
+#define SNAPSHOT_SLOT_BYTES(len) (SNAPSHOT_HEADER_BYTES + (len) + 1)
+#define SNAPSHOT_NONE 0xFFFF
+
+//*****************************************************************************
+//
+// Snapshot class
+//
+// Keeps what the widgets of a Menu are set to in a PageStore, e.g. the
+// EEPROM, so a sketch comes back up the way it was left
+//
+// The state of each panel that has one (a Button's toggle, the value of a
+// Fader or Knob) is packed in menu order into one record. Records go into
+// the store one slot after the other round a ring, so the writes are
+// spread over all of it, and the newest one whose check byte matches is
+// the one restored. A save that wouldn't change anything isn't written,
+// and the store only writes the bytes that differ.
+//
+// restore() is meant to run before the first drawMenu(): the panels take
+// the saved state without drawing, and their methods are called, with
+// getEvent() giving TOUCH_RESTORE, for the ones that changed. On a menu
+// already showing, those panels are repainted at its next flush.
+//
+// Records only match a menu with the same panels holding state, in the
+// same order, so adding one just starts over from the defaults.
+//
+//*****************************************************************************
+class Snapshot
+{
+	private:
+		PageStore &_store;
+		// newest record's slot, SNAPSHOT_NONE before one is found
+		uint16_t _slot;
+		uint16_t _seq;
+		bool _found;
+		// for update(), the menu version last seen and when it changed
+		uint32_t _version;
+		uint32_t _changed;
+		bool _dirty;
+		uint8_t pack( Menu &menu, uint8_t *buf, uint8_t *pshape );
+		bool readSlot( uint16_t slot, uint8_t len, uint8_t shape,
+			uint8_t *buf, uint16_t *pseq );
+		void find( Menu &menu );
+
+	public:
+		Snapshot( PageStore &store );
+		bool restore( Menu &menu );
+		bool save( Menu &menu );
+		void update( Menu &menu );
+		// inline functions
+		inline uint16_t getSlot( void ){ return _slot; }
+		inline uint16_t getSeq( void ){ return _seq; }
+};
+
+#ifdef ARDUINO
+
+#include <EEPROM.h>
+
+//*****************************************************************************
+//
+// EepromStore class
+//
+// The board's EEPROM, or size bytes of it from base, 0 for the rest
+// Writes go through EEPROM.update(), so unchanged bytes aren't worn
+//
+//*****************************************************************************
+class EepromStore: public PageStore
+{
+	private:
+		uint16_t _base;
+		uint16_t _size;
+
+	public:
+		EepromStore( uint16_t base = 0, uint16_t size = 0 ) :
+			_base(base), _size(size) {}
+		uint32_t size( void ){
+			return (_size != 0) ? _size : EEPROM.length() - _base; }
+		uint8_t read( uint32_t addr ){ return EEPROM.read(_base + addr); }
+		bool write( uint32_t addr, uint8_t b ){
+			EEPROM.update(_base + addr, b); return true; }
+};
+
+#else
+
+//*****************************************************************************
+//
+// FileStore class
+//
+// Host stand-in for the EEPROM kept in a file, so what's saved outlives
+// the program the way it outlives a power cycle. Bytes start erased to
+// 0xFF, and like EEPROM.update() only bytes that change are written, and
+// counted.
+//
+//*****************************************************************************
+#ifndef FILE_STORE_MAX
+#define FILE_STORE_MAX 4096
+#endif
+
+class FileStore: public PageStore
+{
+	private:
+		const char *_path;
+		uint8_t _buf[FILE_STORE_MAX];
+		uint32_t _size;
+		uint32_t _writes;
+
+	public:
+		FileStore( const char *path, uint32_t size = 1024 );
+		uint32_t size( void ){ return _size; }
+		uint8_t read( uint32_t addr ){ return _buf[addr]; }
+		bool write( uint32_t addr, uint8_t b );
+		// inline functions
+		inline uint32_t getWrites( void ){ return _writes; }
+		inline void resetWrites( void ){ _writes = 0; }
+};
+
+#endif // ARDUINO
+
+#endif // _snapshot_h_
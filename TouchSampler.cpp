@@ -0,0 +1,200 @@
+#include "TouchSampler.h"
+
+//*****************************************************************************
+//
+// TouchRing class
+//
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+TouchRing::TouchRing( void )
+{
+	_head = 0;
+	_tail = 0;
+	_dropped = 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// push
+//
+// Producer side, returns false and counts a drop when full
+//
+//-----------------------------------------------------------------------------
+bool TouchRing::push( const TouchPoint &p )
+{
+	uint8_t head = _head;
+	uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+	// indices run freely and wrap at 256, so full is a difference of LEN
+	if( (uint8_t)(head - tail) == TOUCH_RING_LEN )
+	{
+		_dropped++;
+		return false;
+	}
+	_buf[head & (TOUCH_RING_LEN - 1)] = p;
+	__atomic_store_n(&_head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// pop
+//
+// Consumer side, returns false when empty
+//
+//-----------------------------------------------------------------------------
+bool TouchRing::pop( TouchPoint &p )
+{
+	uint8_t tail = _tail;
+	uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+	if( head == tail )
+	{
+		return false;
+	}
+	p = _buf[tail & (TOUCH_RING_LEN - 1)];
+	__atomic_store_n(&_tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// available
+//
+//-----------------------------------------------------------------------------
+uint8_t TouchRing::available( void )
+{
+	return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+}
+
+
+//*****************************************************************************
+//
+// TouchSampler class
+//
+//*****************************************************************************
+
+TouchSampler *TouchSampler::_instance = NULL;
+
+//-----------------------------------------------------------------------------
+//
+// Constructor
+//
+//-----------------------------------------------------------------------------
+TouchSampler::TouchSampler( TouchInput &source ) :
+			_source(source)
+{
+	_pin = TOUCH_NO_PIN;
+	_pending = false;
+	_pending_t = 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// attach
+//
+// Samples on the touch controller's interrupt pin (active low)
+// Only one sampler can be attached at a time
+//
+//-----------------------------------------------------------------------------
+void TouchSampler::attach( uint8_t pin, Display *pdisplay )
+{
+	_instance = this;
+	_pin = pin;
+#ifdef ARDUINO
+	pinMode(_pin, INPUT_PULLUP);
+	attachInterrupt(digitalPinToInterrupt(_pin), isr, FALLING);
+#endif
+	if( pdisplay != NULL )
+	{
+		pdisplay->setYield(yield);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// isr
+//
+// Touch started, only note when: the controller is read outside of here
+//
+//-----------------------------------------------------------------------------
+void TouchSampler::isr( void )
+{
+	_instance->_pending_t = millis();
+	_instance->_pending = true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// yield
+//
+//-----------------------------------------------------------------------------
+void TouchSampler::yield( void )
+{
+	_instance->sample();
+}
+
+//-----------------------------------------------------------------------------
+//
+// sample
+//
+// Producer: reads the source into the ring, returns how many were read
+// With an interrupt pin the source is only read when a touch started or
+// is still being held
+//
+//-----------------------------------------------------------------------------
+uint8_t TouchSampler::sample( void )
+{
+	TouchPoint points[2];
+	// the time is 4 bytes the interrupt writes, it's copied with it off so
+	// an 8 bit board can't read half of an old one, and taken along with
+	// the flag so a touch starting after this isn't cleared unread
+#ifdef ARDUINO
+	noInterrupts();
+#endif
+	bool pending = _pending;
+	uint32_t pending_t = _pending_t;
+	_pending = false;
+#ifdef ARDUINO
+	interrupts();
+	if( (_pin != TOUCH_NO_PIN) && !pending && (digitalRead(_pin) == HIGH) )
+	{
+		return 0;
+	}
+#endif
+	uint8_t n = _source.read(points, 2);
+	if( pending )
+	{
+		// first sample of a touch is stamped when it actually happened
+		for( uint8_t i = 0; i < n; i++ )
+		{
+			points[i].t = pending_t;
+		}
+	}
+	for( uint8_t i = 0; i < n; i++ )
+	{
+		_ring.push(points[i]);
+	}
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+//
+// read
+//
+// Consumer: hands out queued samples, oldest first
+//
+//-----------------------------------------------------------------------------
+uint8_t TouchSampler::read( TouchPoint *points, uint8_t max )
+{
+	uint8_t n = 0;
+	while( (n < max) && _ring.pop(points[n]) )
+	{
+		n++;
+	}
+	return n;
+}
@@ -0,0 +1,88 @@
+#ifndef _touch_sampler_h_
+#define _touch_sampler_h_
+
+#include "Display.h"
+
+// samples the ring can hold, must be a power of 2 no bigger than 128
+#ifndef TOUCH_RING_LEN
+#define TOUCH_RING_LEN 16
+#endif
+
+// pin value meaning no interrupt pin, sample() always reads
+#define TOUCH_NO_PIN 0xFF
+
+//*****************************************************************************
+//
+// TouchRing class
+//
+// Lock free single producer / single consumer queue of touch samples
+// The producer only writes _head and the consumer only writes _tail, each
+// published with release / acquire ordering, so one side can be an
+// interrupt or another thread without disabling anything
+//
+//*****************************************************************************
+class TouchRing
+{
+	private:
+		TouchPoint _buf[TOUCH_RING_LEN];
+		uint8_t _head; // next slot to write
+		uint8_t _tail; // next slot to read
+		// samples thrown away because the ring was full, producer only
+		uint16_t _dropped;
+
+	public:
+		TouchRing( void );
+		bool push( const TouchPoint &p );
+		bool pop( TouchPoint &p );
+		uint8_t available( void );
+		// inline functions
+		// only exact once the producer has stopped
+		inline uint16_t getDropped( void ){ return _dropped; }
+};
+
+//*****************************************************************************
+//
+// TouchSampler class
+//
+// Reads another touch backend into a TouchRing, and hands the samples out
+// again through read(), so a Menu can use it like any other TouchInput
+//
+// On the board attach() hooks the FT6206 interrupt pin, which goes low on
+// a touch. The I2C read can't happen in the interrupt itself (Wire needs
+// interrupts), so the interrupt only latches the time, and sample() reads
+// the controller whenever a touch is pending or still held, and is skipped
+// otherwise. Given the display, attach() also has sample() called between
+// the draw commands of every batch, so a long redraw keeps sampling. The
+// display ends its SPI transaction before each of those calls, so the I2C
+// read never runs with the display selected, and every command of a batch
+// then costs a transaction of its own.
+//
+// sample() is the producer and read() the consumer: each must only ever be
+// called from one place. On the host sample() can run on its own thread.
+//
+//*****************************************************************************
+class TouchSampler: public TouchInput
+{
+	private:
+		TouchInput &_source;
+		TouchRing _ring;
+		uint8_t _pin;
+		// set by the interrupt, cleared once the touch is read
+		volatile bool _pending;
+		volatile uint32_t _pending_t;
+		static TouchSampler *_instance;
+		static void isr( void );
+		static void yield( void );
+
+	public:
+		TouchSampler( TouchInput &source );
+		void attach( uint8_t pin, Display *pdisplay = NULL );
+		uint8_t sample( void );
+		uint8_t read( TouchPoint *points, uint8_t max );
+		bool isBuffered( void ){ return true; }
+		// inline functions
+		inline uint8_t available( void ){ return _ring.available(); }
+		inline uint16_t getDropped( void ){ return _ring.getDropped(); }
+};
+
+#endif // _touch_sampler_h_
@@ -0,0 +1,133 @@
+//*****************************************************************************
+//
+// AngleBench
+//
+// Host benchmark of the knob angle math: the old 21 entry table lookup
+// against the CORDIC in Angle.cpp. For both it times the work done per
+// touch and counts how many distinct mark positions a full turn around the
+// knob can produce.
+//
+// Build and run from the library folder:
+//   g++ -O2 -I. extras/bench/AngleBench.cpp Angle.cpp -o anglebench
+//   ./anglebench
+//
+// Prints one JSON object per path.
+//
+//*****************************************************************************
+#include "Angle.h"
+
+#include <stdio.h>
+#include <set>
+#include <utility>
+
+// knob used for every measurement, same shape as a 100 x 100 Knob at 20, 60
+// not const: in Knob these are members, so the compiler can't fold the
+// divisions in map() into multiplies either
+int16_t KNOB_X = 20;
+int16_t KNOB_Y = 60;
+int16_t KNOB_R = 50;
+int16_t BORDER = 2;
+const uint32_t ROUNDS = 200;
+
+//-----------------------------------------------------------------------------
+//
+// Old path, as Knob::updatePanel and getTheta were before Angle.cpp
+//
+//-----------------------------------------------------------------------------
+const uint8_t sin21[] = { 0, 6, 12, 19, 24, 31, 37, 44, 50, 56, 63, 69,
+	75, 81, 89, 95, 101, 107, 114, 121, 128 };
+const uint8_t cos21[] = { 64, 91, 102, 109, 114, 119, 122, 124, 126,
+	127, 127, 127, 126, 125, 122, 119, 115, 110, 103, 92, 64 };
+const uint8_t TRIG_LEN = 21;
+
+static void oldPlot( uint16_t x, uint16_t y, uint16_t *pxplot,
+	uint16_t *pyplot )
+{
+	uint8_t d_border = 2*KNOB_R - 3*BORDER;
+	if( x - KNOB_X < KNOB_R/2 )
+	{
+		x = KNOB_R/2 + KNOB_X;
+	}
+	uint8_t index = map(x - KNOB_X, 0, 2*KNOB_R, 0, TRIG_LEN);
+	uint16_t xplot = map(sin21[index], 0, 128, 0, d_border) + KNOB_X + BORDER;
+	uint16_t yplot = map(cos21[index], 0, 128, 0, d_border);
+	if( y - KNOB_R > KNOB_Y )
+	{
+		yplot += KNOB_Y - BORDER;
+	}
+	else
+	{
+		yplot = KNOB_Y + 2*KNOB_R + BORDER - yplot;
+	}
+	*pxplot = xplot;
+	*pyplot = yplot;
+}
+
+//-----------------------------------------------------------------------------
+//
+// New path, as Knob::updatePanel does it now
+//
+//-----------------------------------------------------------------------------
+static void newPlot( uint16_t x, uint16_t y, uint16_t *pxplot,
+	uint16_t *pyplot )
+{
+	int16_t sint;
+	int16_t cost;
+	int16_t x0 = KNOB_X + KNOB_R;
+	int16_t y0 = KNOB_Y + KNOB_R;
+	uint8_t d = KNOB_R - 2 * BORDER;
+	angleSinCos(angleAtan2((int16_t)y - y0, (int16_t)x - x0), &sint, &cost);
+	*pxplot = x0 + (((int32_t)cost * d + ANGLE_ONE/2) >> ANGLE_SHIFT);
+	*pyplot = y0 + (((int32_t)sint * d + ANGLE_ONE/2) >> ANGLE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------
+//
+// run
+//
+// Touches every pixel of the knob's bounding box ROUNDS times
+//
+//-----------------------------------------------------------------------------
+static void run( const char *name,
+	void (*plot)(uint16_t, uint16_t, uint16_t *, uint16_t *) )
+{
+	std::set< std::pair<uint16_t, uint16_t> > positions;
+	uint32_t checksum = 0;
+	uint32_t touches = 0;
+	unsigned long start = micros();
+	for( uint32_t round = 0; round < ROUNDS; round++ )
+	{
+		for( uint16_t y = KNOB_Y; y < KNOB_Y + 2*KNOB_R; y++ )
+		{
+			for( uint16_t x = KNOB_X; x < KNOB_X + 2*KNOB_R; x++ )
+			{
+				uint16_t xplot, yplot;
+				plot(x, y, &xplot, &yplot);
+				checksum += xplot * 31 + yplot;
+				touches++;
+			}
+		}
+	}
+	unsigned long elapsed = micros() - start;
+	// resolution: distinct marks along a ring of touches at the knob edge
+	for( uint16_t a = 0; a < 1024; a++ )
+	{
+		int16_t sint, cost;
+		angleSinCos(a << 6, &sint, &cost);
+		uint16_t x = KNOB_X + KNOB_R + ((cost * (KNOB_R - 1)) >> ANGLE_SHIFT);
+		uint16_t y = KNOB_Y + KNOB_R + ((sint * (KNOB_R - 1)) >> ANGLE_SHIFT);
+		uint16_t xplot, yplot;
+		plot(x, y, &xplot, &yplot);
+		positions.insert(std::make_pair(xplot, yplot));
+	}
+	printf("{\"path\": \"%s\", \"touches\": %u, \"ns_per_touch\": %.1f, "
+		"\"positions_per_turn\": %u, \"checksum\": %u}\n", name, touches,
+		1000.0 * elapsed / touches, (unsigned)positions.size(), checksum);
+}
+
+int main( void )
+{
+	run("table21", oldPlot);
+	run("cordic", newPlot);
+	return 0;
+}
@@ -0,0 +1,525 @@
+//*****************************************************************************
+//
+// PanelBench
+//
+// Host benchmark of the widget draw and touch paths, run against the
+// framebuffer backend. Each case builds a page, then replays a canned touch
+// script through Menu::update() a number of rounds, and reports per
+// operation (one touch sample, or one full draw) what reached the display
+// and how long it took.
+//
+// Build and run from the library folder:
+//   g++ -O2 -I. extras/bench/PanelBench.cpp Panel.cpp Display.cpp Damage.cpp
+//     Angle.cpp Gesture.cpp FrameBuffer.cpp TouchSampler.cpp PageManager.cpp
+//     CallbackQueue.cpp PanelValue.cpp -o panelbench
+//   ./panelbench
+//
+// Prints one JSON object per case. pixels, primitives, transactions and
+// spi_bytes are exact and should only change with the drawing code,
+// ns_per_op depends on the machine. So does how much preset_recall fits
+// in its budget.
+//
+//*****************************************************************************
+#include "Panel.h"
+#include "PageManager.h"
+#include "FrameBuffer.h"
+
+#include <stdio.h>
+#include <math.h>
+
+const uint16_t ROUNDS = 50;
+const uint16_t SCRIPT_LEN = 256;
+
+static FrameBufferDisplay fb;
+static TouchPoint script[SCRIPT_LEN];
+static uint16_t script_len;
+
+static bool nop( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	return true;
+}
+
+// stands in for a handler doing real work, e.g. recomputing a filter
+static bool slow( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	unsigned long start = micros();
+	while( micros() - start < 100 )
+	{
+	}
+	return true;
+}
+
+static void add( uint16_t x, uint16_t y )
+{
+	script[script_len].x = x;
+	script[script_len].y = y;
+	script[script_len].t = 0;
+	script[script_len].id = 0;
+	script[script_len].count = 1;
+	script_len++;
+}
+
+// a poll with two fingers down
+static void addTwo( uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1 )
+{
+	add(x0, y0);
+	add(x1, y1);
+	script[script_len - 2].count = 2;
+	script[script_len - 1].id = 1;
+	script[script_len - 1].count = 2;
+}
+
+//-----------------------------------------------------------------------------
+//
+// report
+//
+// ops counts the samples or draws of all rounds
+//
+//-----------------------------------------------------------------------------
+static void report( const char *name, uint32_t ops, unsigned long elapsed )
+{
+	const DisplayStats &s = fb.getStats();
+	printf("{\"case\": \"%s\", \"ops\": %u, \"pixels_per_op\": %.1f, "
+		"\"primitives_per_op\": %.2f, \"transactions_per_op\": %.2f, "
+		"\"spi_bytes_per_op\": %.1f, \"ns_per_op\": %.1f}\n", name, ops,
+		(double)s.pixels / ops, (double)s.primitives / ops,
+		(double)s.transactions / ops, (double)s.bytes / ops,
+		1000.0 * elapsed / ops);
+}
+
+//-----------------------------------------------------------------------------
+//
+// replay
+//
+// Runs the script through the menu ROUNDS times, TOUCH_NONE entries lift
+// the finger
+//
+//-----------------------------------------------------------------------------
+static void replay( const char *name, Menu &menu )
+{
+	ScriptedTouch touch(script, script_len);
+	menu.setTouch(&touch);
+	menu.drawMenu();
+	uint32_t ops = 0;
+	for( uint16_t i = 0; i < script_len; i++ )
+	{
+		ops += script[i].x != TOUCH_NONE;
+	}
+	ops *= ROUNDS;
+	fb.resetStats();
+	unsigned long start = micros();
+	for( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		touch.rewind();
+		while( !touch.done() )
+		{
+			menu.update();
+		}
+		// lift between rounds
+		menu.update();
+		// the sketch catching up once a round
+		if( Panel::getQueue() != NULL )
+		{
+			Panel::getQueue()->drain();
+		}
+	}
+	report(name, ops, micros() - start);
+	menu.setTouch(NULL);
+}
+
+//-----------------------------------------------------------------------------
+//
+// cases
+//
+//-----------------------------------------------------------------------------
+static void buildPage( Menu &menu )
+{
+	menu.create<Fader>(0, 0, 240, 40, nop, CYAN);
+	menu.create<Knob>(20, 60, 100, 100, nop, PINK);
+	menu.create<Button>(140, 60, 80, 40, nop, GREEN);
+	menu.create<Sketch>(0, 180, 240, 140, nop, YELLOW);
+}
+
+static void drawPage( void )
+{
+	PageMenu<1024> menu;
+	buildPage(menu);
+	fb.resetStats();
+	unsigned long start = micros();
+	for( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		menu.drawMenu();
+	}
+	report("draw_page", ROUNDS, micros() - start);
+}
+
+// switching back and forth between two pages, without and with a cache
+static void pageSwitch( bool cached )
+{
+	static uint8_t cache[2][4096];
+	PageMenu<1024> first;
+	PageMenu<1024> second;
+	buildPage(first);
+	for( uint16_t i = 0; i < 6; i++ )
+	{
+		second.create<Button>(10 + i * 38, 200, 30, 30, nop, i & 1 ? RED : BLUE);
+	}
+	second.create<Knob>(60, 40, 120, 120, nop, ORANGE);
+	RamStore first_store(cache[0], sizeof(cache[0]));
+	RamStore second_store(cache[1], sizeof(cache[1]));
+	PageManager pages;
+	pages.addPage(&first, cached ? &first_store : NULL);
+	pages.addPage(&second, cached ? &second_store : NULL);
+	pages.cache(0);
+	pages.cache(1);
+	fb.resetStats();
+	unsigned long start = micros();
+	for( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		pages.show(round & 1);
+	}
+	report(cached ? "page_switch_cached" : "page_switch_redraw", ROUNDS,
+		micros() - start);
+}
+
+static void sweepScript( void )
+{
+	script_len = 0;
+	for( uint16_t x = 40; x < 200; x += 2 )
+	{
+		add(x, 20);
+	}
+	for( uint16_t x = 200; x > 40; x -= 8 )
+	{
+		add(x, 20);
+	}
+}
+
+static void faderSweep( void )
+{
+	PageMenu<256> menu;
+	menu.create<Fader>(0, 0, 240, 40, nop, CYAN);
+	sweepScript();
+	replay("fader_sweep", menu);
+}
+
+// a finger resting on a fader and a knob, wobbling by a pixel
+static void noisyHold( bool quantized )
+{
+	PageMenu<256> menu;
+	Fader *pfader = menu.create<Fader>(0, 0, 240, 40, nop, CYAN);
+	Knob *pknob = menu.create<Knob>(20, 60, 100, 100, nop, PINK);
+	if( quantized )
+	{
+		// 32 steps, a quarter step of hysteresis
+		pfader->setRange(0, 1023, 32, 8);
+		pknob->setRange(0, 1023, 32, 8);
+	}
+	script_len = 0;
+	for( uint16_t i = 0; i < 120; i++ )
+	{
+		add(121 + (i * 7) % 3 - 1, 20);
+	}
+	add(TOUCH_NONE, 0);
+	for( uint16_t i = 0; i < 120; i++ )
+	{
+		add(70 + 40 * cos(0.3) + (i * 5) % 3 - 1, 110 + 40 * sin(0.3));
+	}
+	replay(quantized ? "noisy_hold_quantized" : "noisy_hold", menu);
+}
+
+// a button recalling a preset for eight faders, tapped over and over
+static Fader *preset[8];
+
+static bool recall( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	static uint8_t count = 0;
+	count++;
+	for( uint8_t i = 0; i < 8; i++ )
+	{
+		preset[i]->setValue(((count + i) & 1) ? 0 : 170);
+	}
+	return true;
+}
+
+static void presetRecall( uint16_t budget_us )
+{
+	PageMenu<1024> menu;
+	for( uint8_t i = 0; i < 7; i++ )
+	{
+		preset[i] = menu.create<Fader>(0, i * 40, 240, 40, nop, CYAN);
+	}
+	preset[7] = menu.create<Fader>(0, 280, 180, 40, nop, CYAN);
+	menu.create<Button>(190, 280, 50, 40, recall, GREEN);
+	menu.setBudget(budget_us);
+	script_len = 0;
+	add(215, 300);
+	add(TOUCH_NONE, 0);
+	ScriptedTouch touch(script, script_len);
+	menu.setTouch(&touch);
+	menu.drawMenu();
+	fb.resetStats();
+	uint32_t max_pixels = 0;
+	unsigned long max_us = 0;
+	for( uint16_t i = 0; i < ROUNDS * 8; i++ )
+	{
+		if( touch.done() )
+		{
+			touch.rewind();
+		}
+		uint32_t pixels = fb.getStats().pixels;
+		unsigned long start = micros();
+		menu.update();
+		unsigned long us = micros() - start;
+		pixels = fb.getStats().pixels - pixels;
+		max_pixels = pixels > max_pixels ? pixels : max_pixels;
+		max_us = us > max_us ? us : max_us;
+	}
+	printf("{\"case\": \"preset_recall\", \"budget_us\": %u, \"updates\": %u, "
+		"\"pixels_per_op\": %.1f, \"max_pixels_per_update\": %u, "
+		"\"max_update_ns\": %lu}\n", budget_us, ROUNDS * 8,
+		(double)fb.getStats().pixels / (ROUNDS * 8), max_pixels,
+		1000 * max_us);
+	menu.setTouch(NULL);
+}
+
+// two faders moved at once, both points of a poll handled in one update
+static void twoFaders( void )
+{
+	PageMenu<256> menu;
+	menu.create<Fader>(0, 0, 240, 40, nop, CYAN);
+	menu.create<Fader>(0, 60, 240, 40, nop, PINK);
+	script_len = 0;
+	for( uint16_t x = 40; x < 200; x += 2 )
+	{
+		addTwo(x, 20, 240 - x, 80);
+	}
+	replay("two_faders", menu);
+}
+
+// the fader sweep with a slow method, called from the touch or queued
+static void slowMethod( bool queued )
+{
+	CallbackQueue queue;
+	PageMenu<256> menu;
+	menu.create<Fader>(0, 0, 240, 40, slow, CYAN);
+	Panel::setQueue(queued ? &queue : NULL);
+	sweepScript();
+	replay(queued ? "slow_method_queued" : "slow_method_direct", menu);
+	Panel::setQueue(NULL);
+}
+
+static void knobRotation( void )
+{
+	PageMenu<256> menu;
+	menu.create<Knob>(20, 60, 100, 100, nop, PINK);
+	script_len = 0;
+	for( uint16_t i = 0; i < 120; i++ )
+	{
+		double a = i * M_PI / 60;
+		add(70 + 40 * cos(a), 110 + 40 * sin(a));
+	}
+	replay("knob_rotation", menu);
+}
+
+static void sketchStroke( void )
+{
+	PageMenu<512> menu;
+	menu.create<Sketch>(0, 180, 240, 140, nop, YELLOW);
+	script_len = 0;
+	// a slow wave, then a fast one with big jumps between samples
+	for( uint16_t x = 2; x < 238; x += 2 )
+	{
+		add(x, 250 + 50 * sin(x * M_PI / 60));
+	}
+	add(TOUCH_NONE, 0);
+	for( uint16_t x = 2; x < 238; x += 16 )
+	{
+		add(x, 250 + 50 * sin(x * M_PI / 30));
+	}
+	replay("sketch_stroke", menu);
+}
+
+// 8 kHz of a noisy sine, 160 samples and a flush per 20 ms frame, so
+// four columns a frame, ops are samples
+static void graphStream( void )
+{
+	PageMenu<512> menu;
+	Graph *graph = menu.create<Graph>(0, 0, 240, 100, nop, GREEN);
+	graph->setRange(-32768, 32767);
+	graph->setDecimation(40);
+	menu.drawMenu();
+	uint32_t ops = 0;
+	uint16_t noise = 1;
+	fb.resetStats();
+	unsigned long start = micros();
+	for( uint16_t frame = 0; frame < ROUNDS * 20; frame++ )
+	{
+		for( uint16_t i = 0; i < 160; i++ )
+		{
+			// xorshift, so the envelope is never exactly flat
+			noise ^= noise << 7;
+			noise ^= noise >> 9;
+			noise ^= noise << 8;
+			graph->push(20000 * sin(ops * M_PI / 4000) +
+				(int16_t)(noise & 0x7ff) - 0x400);
+			ops++;
+		}
+		menu.flush();
+	}
+	report("graph_stream", ops, micros() - start);
+}
+
+static void buttonTaps( void )
+{
+	PageMenu<48 * Menu::footprint<Button>()> menu;
+	for( uint16_t row = 0; row < 8; row++ )
+	{
+		for( uint16_t col = 0; col < 6; col++ )
+		{
+			menu.create<Button>(col * 40, row * 40, 40, 40, nop, GREEN);
+		}
+	}
+	script_len = 0;
+	for( uint16_t row = 0; row < 8; row++ )
+	{
+		for( uint16_t col = 0; col < 6; col++ )
+		{
+			add(col * 40 + 20, row * 40 + 20);
+			add(TOUCH_NONE, 0);
+		}
+	}
+	replay("button_taps_48", menu);
+}
+
+// a list three screens long under a fixed header, scrolled down and back
+// up 4 rows at a time, ops are scroll steps
+static void menuScroll( void )
+{
+	PageMenu<2048> menu;
+	menu.create<Button>(0, 0, 240, 40, nop, RED);
+	for( uint16_t y = 40; y < 1000; y += 60 )
+	{
+		menu.create<Button>(10, y, 220, 50, nop, GREEN);
+	}
+	fb.setScrollArea(40);
+	fb.fillScreen(BG_COLOR);
+	menu.drawMenu();
+	uint32_t ops = 0;
+	fb.resetStats();
+	unsigned long start = micros();
+	for( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		for( int16_t dy = 4; dy >= -4; dy -= 8 )
+		{
+			for( uint16_t i = 0; i < 170; i++ )
+			{
+				menu.scrollBy(dy);
+				ops++;
+			}
+		}
+	}
+	report("menu_scroll", ops, micros() - start);
+	fb.setScrollArea(0);
+}
+
+// from putting a page up to the method of a touch on its last panel, with
+// drawMenu() and with paintMenu(), for pages of 3 and of 12 panels: knobs
+// and a button in the bottom right corner, which is the one touched
+static unsigned long touched_at;
+static uint32_t touched_pixels;
+
+static bool touched( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	if( touched_at == 0 )
+	{
+		touched_at = micros();
+		touched_pixels = fb.getStats().pixels;
+	}
+	return true;
+}
+
+static void firstTouch( uint8_t rows, bool progressive )
+{
+	PageMenu<12 * Menu::footprint<Knob>()> menu;
+	for( uint8_t row = 0; row < rows; row++ )
+	{
+		for( uint8_t col = 0; col < 3; col++ )
+		{
+			if( (row == rows - 1) && (col == 2) )
+			{
+				menu.create<Button>(col * 80, row * 80, 80, 80, touched,
+					GREEN);
+			}
+			else
+			{
+				menu.create<Knob>(col * 80, row * 80, 80, 80, nop, PINK);
+			}
+		}
+	}
+	script_len = 0;
+	add(200, rows * 80 - 20);
+	add(TOUCH_NONE, 0);
+	ScriptedTouch touch(script, script_len);
+	menu.setTouch(&touch);
+	unsigned long total_us = 0;
+	uint32_t pixels = 0;
+	uint32_t updates = 0;
+	for( uint16_t round = 0; round < ROUNDS; round++ )
+	{
+		fb.fillScreen(BG_COLOR);
+		touch.rewind();
+		fb.resetStats();
+		touched_at = 0;
+		unsigned long start = micros();
+		if( progressive )
+		{
+			menu.paintMenu();
+		}
+		else
+		{
+			menu.drawMenu();
+		}
+		do
+		{
+			menu.update();
+			updates++;
+		}
+		while( !touch.done() || !menu.isFlushed() );
+		total_us += touched_at - start;
+		pixels += touched_pixels;
+	}
+	printf("{\"case\": \"first_touch\", \"progressive\": %s, "
+		"\"panels\": %u, \"first_touch_ns\": %.1f, "
+		"\"pixels_before_touch\": %.1f, \"updates_to_paint\": %.1f}\n",
+		progressive ? "true" : "false", rows * 3,
+		1000.0 * total_us / ROUNDS, (double)pixels / ROUNDS,
+		(double)updates / ROUNDS);
+	menu.setTouch(NULL);
+}
+
+int main( void )
+{
+	Panel::setDisplay(&fb);
+	drawPage();
+	pageSwitch(false);
+	pageSwitch(true);
+	faderSweep();
+	twoFaders();
+	noisyHold(false);
+	noisyHold(true);
+	presetRecall(0);
+	presetRecall(5);
+	slowMethod(false);
+	slowMethod(true);
+	knobRotation();
+	sketchStroke();
+	buttonTaps();
+	graphStream();
+	menuScroll();
+	firstTouch(1, false);
+	firstTouch(4, false);
+	firstTouch(1, true);
+	firstTouch(4, true);
+	return 0;
+}
@@ -0,0 +1,596 @@
+//*****************************************************************************
+//
+// PanelCheck
+//
+// Host checks of what the faster draw and touch paths promise, run against
+// the framebuffer backend. Panels that draw only what changed are compared
+// pixel for pixel with a fresh drawMenu() of the same page after every
+// step of a random script.
+//
+// Build and run from the library folder:
+//   g++ -O2 -I. extras/bench/PanelCheck.cpp Panel.cpp Display.cpp Damage.cpp
+//     Angle.cpp Gesture.cpp FrameBuffer.cpp TouchSampler.cpp PageManager.cpp
+//     CallbackQueue.cpp PanelValue.cpp Snapshot.cpp -o panelcheck
+//   ./panelcheck
+//
+// The per panel counters are checked too when the whole library is built
+// with PANEL_STATS:
+//   g++ -O2 -DPANEL_STATS -I. extras/bench/PanelCheck.cpp Panel.cpp
+//     Display.cpp Damage.cpp Angle.cpp Gesture.cpp FrameBuffer.cpp
+//     TouchSampler.cpp PageManager.cpp CallbackQueue.cpp PanelValue.cpp
+//     Snapshot.cpp -o panelcheck_stats
+//   ./panelcheck_stats
+//
+// Pages built in an arena and cleared are only half checked by the counts,
+// run it under AddressSanitizer too, where any use of a panel that is gone
+// stops it:
+//   g++ -O1 -g -fsanitize=address,undefined -fno-omit-frame-pointer -I.
+//     extras/bench/PanelCheck.cpp Panel.cpp Display.cpp Damage.cpp Angle.cpp
+//     Gesture.cpp FrameBuffer.cpp TouchSampler.cpp PageManager.cpp
+//     CallbackQueue.cpp PanelValue.cpp Snapshot.cpp -o panelcheck_asan
+//   ./panelcheck_asan
+//
+// Prints one JSON object per check, with how many steps were checked and
+// how many of them failed, and exits with 1 if any did. The scripts are
+// seeded, so a failure repeats.
+//
+//*****************************************************************************
+#include "Panel.h"
+#include "FrameBuffer.h"
+#include "Snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+const uint16_t STEPS = 2000;
+
+static FrameBufferDisplay fb;
+static uint16_t frame[MAX_X * MAX_Y];
+static uint32_t seed;
+static bool failed;
+
+static bool nop( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	return true;
+}
+
+// panel whose method ran last, with the event, and how many times
+static Panel *hit;
+static uint8_t hit_event;
+static uint16_t hits;
+
+static bool record( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	hit = ppanel;
+	hit_event = Panel::getEvent();
+	hits++;
+	return true;
+}
+
+// xorshift, the same numbers on every host
+static uint16_t roll( uint16_t n )
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed % n;
+}
+
+//-----------------------------------------------------------------------------
+//
+// report
+//
+//-----------------------------------------------------------------------------
+static void report( const char *name, uint32_t steps, uint32_t bad )
+{
+	printf("{\"check\": \"%s\", \"steps\": %u, \"failed\": %u}\n", name,
+		steps, bad);
+	failed |= bad != 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// sameAsDraw
+//
+// Flushes the menu, then draws it again from a cleared screen. True if
+// both frames are the same, the screen is left with the fresh one.
+//
+//-----------------------------------------------------------------------------
+static bool sameAsDraw( Menu &menu )
+{
+	menu.flush();
+	memcpy(frame, fb.getBuffer(), sizeof(frame));
+	fb.clear(BG_COLOR);
+	menu.drawMenu();
+	return memcmp(frame, fb.getBuffer(), sizeof(frame)) == 0;
+}
+
+//-----------------------------------------------------------------------------
+//
+// checks
+//
+//-----------------------------------------------------------------------------
+
+// faders of different places and widths, moved by touches and from code
+static void faderMoves( void )
+{
+	static const uint8_t f[3][4] = {
+		{ 0, 0, 240, 40 }, { 30, 60, 150, 30 }, { 100, 120, 100, 50 } };
+	PageMenu<512> menu;
+	Fader *pfader[3];
+	for( uint8_t i = 0; i < 3; i++ )
+	{
+		pfader[i] = menu.create<Fader>(f[i][0], f[i][1], f[i][2], f[i][3],
+			nop, i == 0 ? CYAN : (i == 1 ? PINK : GREEN));
+	}
+	fb.clear(BG_COLOR);
+	menu.drawMenu();
+	seed = 15;
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		uint8_t i = roll(3);
+		switch( roll(8) )
+		{
+			case 0:
+				menu.isReleased();
+				break;
+			case 1:
+				pfader[i]->setValue(roll(f[i][2] + 20) - 10);
+				break;
+			default:
+				// the ends too, the fader clamps
+				menu.isTouched(f[i][0] + roll(f[i][2]), f[i][1] + roll(f[i][3]));
+				break;
+		}
+		bad += !sameAsDraw(menu);
+	}
+	report("fader_moves", STEPS, bad);
+}
+
+// knobs of four sizes, one not square, turned to random angles by touches
+// and from code
+static void knobAngles( void )
+{
+	static const uint8_t k[4][4] = {
+		{ 0, 0, 100, 100 }, { 120, 10, 41, 41 }, { 20, 150, 200, 160 },
+		{ 180, 80, 12, 12 } };
+	PageMenu<512> menu;
+	Knob *pknob[4];
+	for( uint8_t i = 0; i < 4; i++ )
+	{
+		pknob[i] = menu.create<Knob>(k[i][0], k[i][1], k[i][2], k[i][3], nop,
+			i & 1 ? PINK : GREEN);
+	}
+	fb.clear(BG_COLOR);
+	menu.drawMenu();
+	seed = 16;
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		uint8_t i = roll(4);
+		uint8_t r = (k[i][2] < k[i][3] ? k[i][2] : k[i][3]) / 2;
+		double a = roll(3600) * M_PI / 1800;
+		switch( roll(8) )
+		{
+			case 0:
+				menu.isReleased();
+				break;
+			case 1:
+				pknob[i]->setValue(roll(256));
+				break;
+			default:
+				// anywhere from the center to the ring
+				double d = r * roll(100) / 100.0;
+				menu.isTouched(k[i][0] + r + lround(d * cos(a)),
+					k[i][1] + r - lround(d * sin(a)));
+				break;
+		}
+		bad += !sameAsDraw(menu);
+	}
+	report("knob_angles", STEPS, bad);
+}
+
+// overlapping buttons tapped by one or two fingers per poll, over a knob,
+// a fader and a graph that is cleared now and then, so the damage list
+// merges and clips regions that cut across other panels
+static void damageRepaint( void )
+{
+	PageMenu<12 * Menu::footprint<Button>() + Menu::footprint<Knob>() +
+		Menu::footprint<Fader>() + Menu::footprint<Graph>()> menu;
+	seed = 2;
+	for( uint8_t i = 0; i < 12; i++ )
+	{
+		uint8_t w = 20 + roll(80);
+		uint16_t h = 20 + roll(80);
+		menu.create<Button>(roll(MAX_X - w), roll(MAX_Y - h), w, h, nop,
+			i & 1 ? RED : BLUE);
+	}
+	menu.create<Knob>(60, 60, 120, 120, nop, PINK);
+	menu.create<Fader>(0, 150, 240, 40, nop, CYAN);
+	Graph *pgraph = menu.create<Graph>(0, 200, 240, 120, nop, GREEN);
+	fb.clear(BG_COLOR);
+	menu.drawMenu();
+	TouchPoint poll[3];
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		uint8_t fingers = 1 + roll(2);
+		for( uint8_t i = 0; i < fingers; i++ )
+		{
+			poll[i].x = roll(MAX_X);
+			poll[i].y = roll(MAX_Y);
+			poll[i].id = i;
+			poll[i].count = fingers;
+		}
+		// lifted in the next poll
+		poll[fingers].x = TOUCH_NONE;
+		ScriptedTouch touch(poll, fingers + 1);
+		menu.setTouch(&touch);
+		while( !touch.done() )
+		{
+			menu.update();
+		}
+		if( roll(8) == 0 )
+		{
+			pgraph->push(roll(1024) - 512);
+			pgraph->clear();
+		}
+		bad += !sameAsDraw(menu);
+	}
+	menu.setTouch(NULL);
+	report("damage_repaint", STEPS, bad);
+}
+
+// random layouts of 40 buttons, past the 32 the grid indexes, a few of
+// them disabled, tapped at random points: the grid must pick the same
+// panel as walking the list for the first enabled one under the finger
+static void gridLookup( void )
+{
+	const uint8_t BUTTONS = 40;
+	PageMenu<BUTTONS * Menu::footprint<Button>()> menu;
+	seed = 3;
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		if( step % 100 == 0 )
+		{
+			menu.clear();
+			for( uint8_t i = 0; i < BUTTONS; i++ )
+			{
+				uint8_t w = 10 + roll(90);
+				uint16_t h = 10 + roll(90);
+				Button *pbutton = menu.create<Button>(roll(MAX_X - w),
+					roll(MAX_Y - h), w, h, record, BLUE);
+				pbutton->setEnable(roll(8) != 0);
+			}
+			menu.drawMenu();
+		}
+		uint16_t x = roll(MAX_X);
+		uint16_t y = roll(MAX_Y);
+		Panel *pfirst = menu.getHead();
+		while( (pfirst != NULL) && !pfirst->contains(x, y) )
+		{
+			pfirst = pfirst->getNext();
+		}
+		hit = NULL;
+		menu.isTouched(x, y);
+		menu.isReleased();
+		bad += hit != pfirst;
+	}
+	report("grid_lookup", STEPS, bad);
+}
+
+// buttons tapped through isTouched() alone, the way a sketch written
+// before isReleased() polls: each tap lands on another button than the
+// last, with one to three samples, and must press it once. A repeating
+// button held down the same way gets its long press and a repeat.
+static void legacyTaps( void )
+{
+	PageMenu<7 * Menu::footprint<Button>()> menu;
+	Button *pbutton[6];
+	for( uint8_t i = 0; i < 6; i++ )
+	{
+		pbutton[i] = menu.create<Button>((i % 3) * 80, (i / 3) * 80, 70, 70,
+			record, BLUE);
+	}
+	Button *prepeat = menu.create<Button>(0, 200, 70, 70, record, RED);
+	prepeat->setRepeat(true);
+	menu.drawMenu();
+	seed = 8;
+	uint32_t bad = 0;
+	uint8_t last = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		uint8_t i = (last + 1 + roll(5)) % 6;
+		hit = NULL;
+		hits = 0;
+		for( uint8_t n = 1 + roll(3); n > 0; n-- )
+		{
+			menu.isTouched(pbutton[i]->getX() + roll(70),
+				pbutton[i]->getY() + roll(70));
+		}
+		bad += (hits != 1) || (hit != pbutton[i]);
+		last = i;
+	}
+	report("legacy_taps", STEPS, bad);
+	// a sample every 20 ms, well inside the release time
+	bool long_press = false;
+	hits = 0;
+	for( uint32_t start = millis(); millis() - start < MENU_LONG_PRESS_MS +
+		2 * MENU_REPEAT_MS; )
+	{
+		menu.isTouched(30, 230);
+		long_press |= (hit == prepeat) && (hit_event == TOUCH_LONG_PRESS);
+		usleep(20000);
+	}
+	report("legacy_hold", 1, !long_press || (hits < 3));
+}
+
+// a page of four faders and a knob built in its arena, with a heap button
+// added alongside, used and cleared over and over: the arena must come
+// back empty, refuse a panel past its end, and each build must draw the
+// same frame. Methods still queued for the cleared panels must go too.
+static void arenaRebuild( void )
+{
+	const uint16_t ARENA = 4 * Menu::footprint<Fader>() +
+		Menu::footprint<Knob>();
+	static uint16_t first[MAX_X * MAX_Y];
+	PageMenu<ARENA> menu;
+	CallbackQueue queue;
+	Panel::setQueue(&queue);
+	seed = 6;
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < STEPS; step++ )
+	{
+		bool built = true;
+		for( uint8_t i = 0; i < 4; i++ )
+		{
+			built &= menu.create<Fader>(0, i * 50, 240, 40, nop, CYAN) != NULL;
+		}
+		built &= menu.create<Knob>(20, 200, 100, 100, nop, PINK) != NULL;
+		// full now
+		built &= menu.create<Fader>(0, 0, 240, 40, nop, CYAN) == NULL;
+		menu.addPanel(new Button(140, 200, 80, 40, nop, GREEN));
+		built &= menu.getArenaUsed() == ARENA;
+		fb.clear(BG_COLOR);
+		menu.drawMenu();
+		if( step == 0 )
+		{
+			memcpy(first, fb.getBuffer(), sizeof(first));
+		}
+		built &= memcmp(first, fb.getBuffer(), sizeof(first)) == 0;
+		// leave the button's method and a fader's in the queue
+		menu.isTouched(180, 220);
+		menu.isReleased();
+		menu.isTouched(roll(MAX_X), 20);
+		menu.isReleased();
+		menu.clear();
+		built &= (menu.getArenaUsed() == 0) && (menu.getHead() == NULL) &&
+			(queue.available() == 0);
+		bad += !built;
+	}
+	Panel::setQueue(NULL);
+	report("arena_rebuild", STEPS, bad);
+}
+
+// two faders, a knob and a button saved to a file, changed, and put back,
+// on the page still showing or on one built again the way it would be
+// after a power cycle: the frame must come back the same as when it was
+// saved, and a save must only write the bytes it changes
+const char *SNAPSHOT_PATH = "/tmp/panelcheck_snapshot.bin";
+
+static Fader *psnap_fader[2];
+static Knob *psnap_knob;
+static Button *psnap_button;
+
+static void snapshotPage( Menu &menu )
+{
+	psnap_fader[0] = menu.create<Fader>(0, 0, 240, 40, nop, CYAN);
+	psnap_fader[1] = menu.create<Fader>(30, 60, 150, 30, nop, PINK);
+	psnap_knob = menu.create<Knob>(20, 110, 100, 100, nop, GREEN);
+	psnap_button = menu.create<Button>(140, 200, 80, 40, nop, BLUE);
+}
+
+static void snapshotChange( Menu &menu )
+{
+	for( uint8_t n = 1 + roll(3); n > 0; n-- )
+	{
+		switch( roll(4) )
+		{
+			case 0:
+				psnap_fader[0]->setValue(roll(240));
+				break;
+			case 1:
+				psnap_fader[1]->setValue(roll(150));
+				break;
+			case 2:
+				psnap_knob->setValue(roll(256));
+				break;
+			default:
+				menu.isTouched(180, 220);
+				menu.isReleased();
+				break;
+		}
+	}
+}
+
+static void snapshotRestore( void )
+{
+	static uint16_t saved[MAX_X * MAX_Y];
+	static uint8_t image[1024];
+	const uint16_t ROUNDS = STEPS / 10;
+	remove(SNAPSHOT_PATH);
+	PageMenu<2 * Menu::footprint<Fader>() + Menu::footprint<Knob>() +
+		Menu::footprint<Button>()> menu;
+	snapshotPage(menu);
+	fb.clear(BG_COLOR);
+	menu.drawMenu();
+	FileStore *pstore = new FileStore(SNAPSHOT_PATH, sizeof(image));
+	Snapshot *psnap = new Snapshot(*pstore);
+	seed = 24;
+	uint32_t bad = 0;
+	for( uint16_t step = 0; step < ROUNDS; step++ )
+	{
+		snapshotChange(menu);
+		bool ok = sameAsDraw(menu);
+		memcpy(saved, fb.getBuffer(), sizeof(saved));
+		for( uint16_t i = 0; i < sizeof(image); i++ )
+		{
+			image[i] = pstore->read(i);
+		}
+		uint32_t writes = pstore->getWrites();
+		// nothing is written when the newest record is already the same
+		bool wrote = psnap->save(menu);
+		uint32_t changed = 0;
+		for( uint16_t i = 0; i < sizeof(image); i++ )
+		{
+			changed += image[i] != pstore->read(i);
+		}
+		ok &= (pstore->getWrites() - writes == changed) &&
+			(wrote == (changed != 0)) && (changed <= SNAPSHOT_SLOT_BYTES(7));
+		snapshotChange(menu);
+		if( roll(4) == 0 )
+		{
+			// power cycle, the file must hold what the store did
+			delete psnap;
+			delete pstore;
+			pstore = new FileStore(SNAPSHOT_PATH, sizeof(image));
+			psnap = new Snapshot(*pstore);
+			FILE *fp = fopen(SNAPSHOT_PATH, "rb");
+			ok &= (fp != NULL) && (fread(image, 1, sizeof(image), fp) ==
+				sizeof(image));
+			if( fp != NULL )
+			{
+				fclose(fp);
+			}
+			for( uint16_t i = 0; i < sizeof(image); i++ )
+			{
+				ok &= image[i] == pstore->read(i);
+			}
+			menu.clear();
+			snapshotPage(menu);
+			ok &= psnap->restore(menu);
+			fb.clear(BG_COLOR);
+			menu.drawMenu();
+		}
+		else
+		{
+			// the page showing repaints what came back, and a restore
+			// that changes it is a new version
+			menu.flush();
+			bool moved = memcmp(saved, fb.getBuffer(), sizeof(saved)) != 0;
+			uint32_t version = menu.getVersion();
+			ok &= psnap->restore(menu);
+			menu.flush();
+			ok &= !moved || (menu.getVersion() != version);
+		}
+		ok &= memcmp(saved, fb.getBuffer(), sizeof(saved)) == 0;
+		bad += !ok;
+	}
+	delete psnap;
+	delete pstore;
+	remove(SNAPSHOT_PATH);
+	report("snapshot_restore", ROUNDS, bad);
+}
+
+#if DISPLAY_STATS
+// the display's counters for one rectangle, then two in a batch that
+// merge into one command
+static void displayCounts( void )
+{
+	const uint32_t WINDOW = DISPLAY_CASET_BYTES + DISPLAY_PASET_BYTES +
+		DISPLAY_RAMWR_BYTES;
+	uint32_t steps = 0;
+	uint32_t bad = 0;
+	fb.resetStats();
+	fb.fillRect(0, 0, 10, 10, RED);
+	const DisplayStats &s = fb.getStats();
+	steps += 5;
+	bad += (s.primitives != 1) + (s.pixels != 100) + (s.drawn != 100) +
+		(s.transactions != 1) + (s.bytes != WINDOW + 200);
+	fb.resetStats();
+	fb.beginBatch();
+	fb.fillRect(0, 0, 10, 10, RED);
+	fb.fillRect(10, 0, 10, 10, RED);
+	fb.endBatch();
+	const DisplayStats &b = fb.getBatchStats();
+	steps += 10;
+	bad += (s.primitives != 2) + (s.pixels != 200) + (s.drawn != 200) +
+		(s.transactions != 1) + (s.bytes != WINDOW + 400);
+	bad += (b.primitives != 2) + (b.pixels != 200) + (b.drawn != 200) +
+		(b.transactions != 1) + (b.bytes != WINDOW + 400);
+	report("display_counts", steps, bad);
+}
+#endif
+
+#ifdef PANEL_STATS
+// a button and a fader drawn, the button tapped and the fader dragged:
+// each panel's counters only move for what happened to it, and its
+// pixels are what the display was asked for on its behalf
+static void panelCounts( void )
+{
+	PageMenu<Menu::footprint<Button>() + Menu::footprint<Fader>()> menu;
+	Button *pbutton = menu.create<Button>(0, 0, 60, 60, nop, BLUE);
+	Fader *pfader = menu.create<Fader>(0, 100, 240, 40, nop, CYAN);
+	const PanelStats &b = pbutton->getStats();
+	const PanelStats &f = pfader->getStats();
+	const DisplayStats &s = fb.getStats();
+	uint32_t steps = 0;
+	uint32_t bad = 0;
+	// nothing but the panels is drawn
+	fb.clear(BG_COLOR);
+	fb.resetStats();
+	menu.resetStats();
+	menu.drawMenu();
+	steps += 5;
+	bad += (b.draws != 1) + (f.draws != 1) + (b.events != 0) +
+		(f.events != 0) + (b.pixels + f.pixels != s.drawn);
+	// press and release, the button repaints through the damage list,
+	// which clears the region outside of drawPanel()
+	fb.resetStats();
+	menu.resetStats();
+	menu.isTouched(30, 30);
+	menu.isReleased();
+	steps += 4;
+	bad += (b.events != 2) + (b.draws == 0) + (b.pixels > s.drawn) +
+		(f.draws + f.pixels + f.events != 0);
+	// press, two moves and a release, drawn by render() alone
+	fb.resetStats();
+	menu.resetStats();
+	menu.isTouched(50, 120);
+	menu.isTouched(100, 120);
+	menu.isTouched(150, 120);
+	menu.isReleased();
+	steps += 4;
+	bad += (f.events != 4) + (f.draws != 0) + (f.pixels != s.drawn) +
+		(b.draws + b.pixels + b.events != 0);
+	report("panel_counts", steps, bad);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//
+// main
+//
+//-----------------------------------------------------------------------------
+int main( void )
+{
+	Panel::setDisplay(&fb);
+	faderMoves();
+	knobAngles();
+	damageRepaint();
+	gridLookup();
+	arenaRebuild();
+	legacyTaps();
+	snapshotRestore();
+#if DISPLAY_STATS
+	displayCounts();
+#endif
+#ifdef PANEL_STATS
+	panelCounts();
+#endif
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+//*****************************************************************************
+//
+// RingBench
+//
+// Host benchmark of touch sampling while the screen is busy. A finger is
+// dragged across a Sketch at a steady sample rate while the loop spends a
+// fixed time per Menu::update() redrawing. Polled reads the touch source
+// once per update, the way Menu did before TouchSampler; sampled has a
+// thread standing in for the touch interrupt, feeding a TouchSampler.
+//
+// Build and run from the library folder:
+//   g++ -O2 -pthread -I. extras/bench/RingBench.cpp Panel.cpp Display.cpp
+//     Damage.cpp Angle.cpp Gesture.cpp FrameBuffer.cpp TouchSampler.cpp
+//     CallbackQueue.cpp PanelValue.cpp -o ringbench
+//   ./ringbench
+//
+// Prints one JSON object per path.
+//
+//*****************************************************************************
+#include "Panel.h"
+#include "FrameBuffer.h"
+
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+
+const uint32_t SAMPLES = 400; // samples in the drag
+const uint32_t SAMPLE_US = 2500; // 400 Hz from the controller
+const uint32_t REDRAW_US = 20000; // time each update spends drawing
+
+static FrameBufferDisplay fb;
+static uint32_t handled;
+
+//-----------------------------------------------------------------------------
+//
+// DragTouch
+//
+// Finger moving back and forth across the sketch area, one position per
+// SAMPLE_US of wall time, so nothing is seen unless it's read in time
+//
+//-----------------------------------------------------------------------------
+class DragTouch: public TouchInput
+{
+	private:
+		unsigned long _start;
+
+	public:
+		DragTouch( void ){ _start = micros(); }
+		uint32_t position( void ){ return (micros() - _start) / SAMPLE_US; }
+		bool done( void ){ return position() >= SAMPLES; }
+		uint8_t read( TouchPoint *points, uint8_t max )
+		{
+			uint32_t i = position();
+			if( (max == 0) || (i >= SAMPLES) )
+			{
+				return 0;
+			}
+			points[0].x = 10 + (i * 3) % 220;
+			points[0].y = 200 + (i % 100);
+			points[0].t = millis();
+			points[0].id = 0;
+			points[0].count = 1;
+			return 1;
+		}
+};
+
+static bool count( uint16_t x, uint16_t y, Panel *ppanel )
+{
+	handled++;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// run
+//
+//-----------------------------------------------------------------------------
+static void run( const char *name, bool sampled )
+{
+	uint8_t storage[512];
+	Menu menu(storage, sizeof(storage));
+	menu.create<Sketch>(0, 180, 240, 140, count, YELLOW);
+	menu.drawMenu();
+	handled = 0;
+	DragTouch drag;
+	TouchSampler sampler(drag);
+	uint32_t produced = 0;
+	bool stop = false;
+	std::thread producer;
+	if( sampled )
+	{
+		menu.setTouch(&sampler);
+		producer = std::thread([&]() {
+			uint32_t last = SAMPLES;
+			while( !__atomic_load_n(&stop, __ATOMIC_ACQUIRE) )
+			{
+				uint32_t i = drag.position();
+				if( (i != last) && (i < SAMPLES) )
+				{
+					produced += sampler.sample();
+					last = i;
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		});
+	}
+	else
+	{
+		menu.setTouch(&drag);
+	}
+	uint32_t updates = 0;
+	while( !drag.done() || (sampled && (sampler.available() > 0)) )
+	{
+		menu.update();
+		updates++;
+		std::this_thread::sleep_for(std::chrono::microseconds(REDRAW_US));
+	}
+	if( sampled )
+	{
+		__atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+		producer.join();
+	}
+	else
+	{
+		// every sample read was handled
+		produced = handled;
+	}
+	printf("{\"path\": \"%s\", \"samples\": %u, \"read\": %u, "
+		"\"handled\": %u, \"dropped\": %u, \"lost_pct\": %.1f, "
+		"\"updates\": %u}\n", name, SAMPLES, produced, handled,
+		sampled ? sampler.getDropped() : 0,
+		100.0 * (SAMPLES - handled) / SAMPLES, updates);
+}
+
+int main( void )
+{
+	Panel::setDisplay(&fb);
+	run("polled", false);
+	run("sampled", true);
+	return 0;
+}